@@ -35,6 +35,10 @@
 #define BASE_PORT_MIN 1
 #define BASE_PORT_MAX 65534
 
+// PSI_DEMO_UDP_TRANSPORT makes the provider own the udp sockets instead of
+//   relaying packets through RtpBinding
+static bool useProviderTransport() { return qEnvironmentVariableIsSet("PSI_DEMO_UDP_TRANSPORT"); }
+
 static QString urlishEncode(const QString &in)
 {
     QString out;
@@ -434,6 +438,7 @@ void RtpBinding::net_ready(int offset)
     // here we handle packets received from the network, that
     //   we need to give to psimedia
 
+    QVector<PsiMedia::RtpPacket> packets;
     while (socketGroup->socket[offset].hasPendingDatagrams()) {
         int        size = int(socketGroup->socket[offset].pendingDatagramSize());
         QByteArray rawValue;
@@ -448,9 +453,11 @@ void RtpBinding::net_ready(int offset)
         if (mode == Send && offset == 0)
             continue;
 
-        PsiMedia::RtpPacket packet(rawValue, offset);
-        channel->write(packet);
+        packets += PsiMedia::RtpPacket(rawValue, offset);
     }
+
+    if (!packets.isEmpty())
+        channel->writeBatch(packets);
 }
 
 void RtpBinding::net_written(int offset)
@@ -464,9 +471,9 @@ void RtpBinding::app_ready()
     // here we handle packets that psimedia wants to send out,
     //   that we need to give to the network
 
-    while (channel->packetsAvailable() > 0) {
-        PsiMedia::RtpPacket packet = channel->read();
-        int                 offset = packet.portOffset();
+    const QVector<PsiMedia::RtpPacket> packets = channel->readAll();
+    for (const PsiMedia::RtpPacket &packet : packets) {
+        int offset = packet.portOffset();
         if (offset < 0 || offset > 1)
             continue;
 
@@ -756,6 +763,23 @@ void MainWin::start_send()
         videoParamsList += config.videoParams;
     producer.setLocalVideoPreferences(videoParamsList);
 
+    if (useProviderTransport()) {
+        // the provider needs to know where to send before it starts. the
+        //   fields are validated again when transmitting
+        PsiMedia::UdpTransport audioTransport;
+        PsiMedia::UdpTransport videoTransport;
+        if (transmitAudio) {
+            audioTransport.remoteAddress  = ui.le_remoteAddress->text();
+            audioTransport.remoteBasePort = ui.le_remoteAudioPort->text().toInt();
+        }
+        if (transmitVideo) {
+            videoTransport.remoteAddress  = ui.le_remoteAddress->text();
+            videoTransport.remoteBasePort = ui.le_remoteVideoPort->text().toInt();
+        }
+        producer.setAudioUdpTransport(audioTransport);
+        producer.setVideoUdpTransport(videoTransport);
+    }
+
     ui.pb_startSend->setEnabled(false);
     ui.pb_stopSend->setEnabled(true);
     transmitting = false;
@@ -790,15 +814,17 @@ void MainWin::transmit()
         }
     }
 
-    auto audioSocketGroup      = new RtpSocketGroup;
-    sendAudioRtp               = new RtpBinding(RtpBinding::Send, producer.audioRtpChannel(), audioSocketGroup, this);
-    sendAudioRtp->sendAddress  = addr;
-    sendAudioRtp->sendBasePort = audioPort;
+    if (!useProviderTransport()) {
+        auto audioSocketGroup      = new RtpSocketGroup;
+        sendAudioRtp               = new RtpBinding(RtpBinding::Send, producer.audioRtpChannel(), audioSocketGroup, this);
+        sendAudioRtp->sendAddress  = addr;
+        sendAudioRtp->sendBasePort = audioPort;
 
-    auto videoSocketGroup      = new RtpSocketGroup;
-    sendVideoRtp               = new RtpBinding(RtpBinding::Send, producer.videoRtpChannel(), videoSocketGroup, this);
-    sendVideoRtp->sendAddress  = addr;
-    sendVideoRtp->sendBasePort = videoPort;
+        auto videoSocketGroup      = new RtpSocketGroup;
+        sendVideoRtp               = new RtpBinding(RtpBinding::Send, producer.videoRtpChannel(), videoSocketGroup, this);
+        sendVideoRtp->sendAddress  = addr;
+        sendVideoRtp->sendBasePort = videoPort;
+    }
 
     setSendFieldsEnabled(false);
     ui.pb_transmit->setEnabled(false);
@@ -877,6 +903,24 @@ void MainWin::start_receive()
         receiver.setRemoteVideoPreferences(payloadInfoList);
     }
 
+    if (useProviderTransport()) {
+        // bind errors are reported through the session's error signal
+        PsiMedia::UdpTransport audioTransport;
+        PsiMedia::UdpTransport videoTransport;
+        if (receiveAudio)
+            audioTransport.localBasePort = audioPort;
+        if (receiveVideo)
+            videoTransport.localBasePort = videoPort;
+        receiver.setAudioUdpTransport(audioTransport);
+        receiver.setVideoUdpTransport(videoTransport);
+
+        setReceiveFieldsEnabled(false);
+        ui.pb_startReceive->setEnabled(false);
+        ui.pb_stopReceive->setEnabled(true);
+        receiver.start();
+        return;
+    }
+
     auto audioSocketGroup = new RtpSocketGroup(this);
     auto videoSocketGroup = new RtpSocketGroup(this);
     if (!audioSocketGroup->bind(audioPort)) {
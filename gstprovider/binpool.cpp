@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "binpool.h"
+
+#include "bins.h"
+
+#include <QSize>
+#include <gst/gst.h>
+
+// bins kept ready per setup
+#define DEFAULT_BIN_POOL_SIZE 1
+
+namespace PsiMedia {
+
+namespace {
+
+    class Setup {
+    public:
+        QString                        key;
+        std::function<GstElement *()> make;
+    };
+
+    Setup audioencSetup(const QString &codec, int rate, int size, int channels)
+    {
+        return { QString("audioenc/%1/%2/%3/%4").arg(codec).arg(rate).arg(size).arg(channels),
+                 [=]() { return bins_audioenc_create(codec, -1, rate, size, channels); } };
+    }
+
+    // the bitrate and realtime tuning are applied when the bin is taken,
+    //   so they aren't part of the setup
+    Setup videoencSetup(const QString &codec)
+    {
+        return { QString("videoenc/%1").arg(codec),
+                 [=]() { return bins_videoenc_create(codec, -1, -1, QSize(), false); } };
+    }
+
+    Setup audiodecSetup(const QString &codec)
+    {
+        return { QString("audiodec/%1").arg(codec), [=]() { return bins_audiodec_create(codec); } };
+    }
+
+    Setup videodecSetup(const QString &codec)
+    {
+        return { QString("videodec/%1").arg(codec), [=]() { return bins_videodec_create(codec); } };
+    }
+
+    int get_pool_size()
+    {
+        QString val = QString::fromLatin1(qgetenv("PSI_BIN_POOL_SIZE"));
+        if (!val.isEmpty())
+            return qMax(val.toInt(), 0);
+        else
+            return DEFAULT_BIN_POOL_SIZE;
+    }
+
+    void discard(GstElement *bin)
+    {
+        gst_element_set_state(bin, GST_STATE_NULL);
+        gst_object_ref_sink(bin);
+        gst_object_unref(bin);
+    }
+
+}
+
+BinPool::BinPool() : size_(get_pool_size()) { }
+
+BinPool *BinPool::instance()
+{
+    // never destroyed, stop() is what releases the bins
+    static auto pool = new BinPool;
+    return pool;
+}
+
+void BinPool::start(GMainContext *context)
+{
+    QMutexLocker locker(&mutex_);
+    if (context_ || size_ == 0)
+        return;
+
+    context_ = g_main_context_ref(context);
+
+    // what RtpWorker builds for a call with the default settings
+    for (const Setup &s :
+         { audioencSetup("opus", 16000, 16, 2), videoencSetup("vp8"), audiodecSetup("opus"), videodecSetup("vp8") })
+        entries_[s.key].make = s.make;
+
+    scheduleRefill();
+}
+
+void BinPool::stop()
+{
+    QMutexLocker locker(&mutex_);
+    if (refill_) {
+        g_source_destroy(refill_);
+        g_source_unref(refill_);
+        refill_ = nullptr;
+    }
+    if (context_) {
+        g_main_context_unref(context_);
+        context_ = nullptr;
+    }
+
+    for (const Entry &e : std::as_const(entries_)) {
+        for (GstElement *bin : e.bins)
+            discard(bin);
+    }
+    entries_.clear();
+}
+
+GstElement *BinPool::audioenc(const QString &codec, int id, int rate, int size, int channels, const POpusOptions &opus)
+{
+    Setup       s   = audioencSetup(codec, rate, size, channels);
+    GstElement *bin = take(s.key, s.make);
+    if (!bin)
+        return nullptr;
+    if (id != -1)
+        bins_rtppay_set_pt(bin, id);
+    bins_audioenc_configure(bin, opus);
+    return bin;
+}
+
+GstElement *BinPool::videoenc(const QString &codec, int id, int maxkbps, const QSize &size, bool realtime)
+{
+    Setup       s   = videoencSetup(codec);
+    GstElement *bin = take(s.key, s.make);
+    if (!bin)
+        return nullptr;
+    if (id != -1)
+        bins_rtppay_set_pt(bin, id);
+    bins_videoenc_configure(bin, maxkbps, size, realtime);
+    return bin;
+}
+
+GstElement *BinPool::audiodec(const QString &codec, const POpusOptions &opus)
+{
+    Setup       s   = audiodecSetup(codec);
+    GstElement *bin = take(s.key, s.make);
+    if (bin)
+        bins_audiodec_configure(bin, opus);
+    return bin;
+}
+
+GstElement *BinPool::videodec(const QString &codec)
+{
+    Setup s = videodecSetup(codec);
+    return take(s.key, s.make);
+}
+
+BinPool::Stats BinPool::stats() const
+{
+    Stats s;
+    s.hits   = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    return s;
+}
+
+GstElement *BinPool::take(const QString &key, const std::function<GstElement *()> &make)
+{
+    GstElement *bin = nullptr;
+    {
+        QMutexLocker locker(&mutex_);
+        if (context_) {
+            Entry &e = entries_[key];
+            if (!e.make)
+                e.make = make;
+            if (!e.bins.isEmpty())
+                bin = e.bins.takeFirst();
+            scheduleRefill();
+        }
+    }
+
+    if (bin) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return bin;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return make();
+}
+
+// mutex_ must be locked
+void BinPool::scheduleRefill()
+{
+    if (refill_ || !context_)
+        return;
+
+    // after anything a session is doing on the same loop
+    refill_ = g_idle_source_new();
+    g_source_set_priority(refill_, G_PRIORITY_LOW);
+    g_source_set_callback(refill_, cb_refill, this, nullptr);
+    g_source_attach(refill_, context_);
+}
+
+gboolean BinPool::cb_refill(gpointer data) { return static_cast<BinPool *>(data)->refill(); }
+
+// builds one bin per call, so the loop gets to run in between
+gboolean BinPool::refill()
+{
+    QString                        key;
+    std::function<GstElement *()> make;
+    {
+        QMutexLocker locker(&mutex_);
+        if (!context_)
+            return FALSE;
+
+        for (auto it = entries_.cbegin(); it != entries_.cend(); ++it) {
+            if (it->bins.count() < size_) {
+                key  = it.key();
+                make = it->make;
+                break;
+            }
+        }
+
+        if (key.isEmpty()) {
+            g_source_unref(refill_);
+            refill_ = nullptr;
+            return FALSE;
+        }
+    }
+
+    GstElement *bin = make();
+    if (bin)
+        gst_element_set_state(bin, GST_STATE_READY);
+
+    QMutexLocker locker(&mutex_);
+    auto         it = entries_.find(key);
+    if (!bin) {
+        // the elements aren't available, don't keep trying
+        if (it != entries_.end())
+            entries_.erase(it);
+    } else if (!context_ || it == entries_.end())
+        discard(bin);
+    else
+        it->bins += bin;
+
+    return TRUE;
+}
+
+} // namespace PsiMedia
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_BINPOOL_H
+#define PSIMEDIA_BINPOOL_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <gst/gstelement.h>
+
+namespace PsiMedia {
+
+class POpusOptions;
+
+// encoder and decoder bins built ahead of time and kept in READY, so that
+//   starting a session mostly comes down to linking. opus and vp8 in the
+//   setups RtpWorker uses are warmed from the start, and any other setup
+//   is kept warm once it has been asked for. bins taken are replaced from
+//   the provider's glib loop, never from the caller
+class BinPool {
+public:
+    class Stats {
+    public:
+        quint64 hits   = 0; // bins handed out ready made
+        quint64 misses = 0; // bins that had to be built on the spot
+    };
+
+    static BinPool *instance();
+
+    // called by the provider. bins are built on the thread of context from
+    //   start() until stop(), which also drops everything pooled
+    void start(GMainContext *context);
+    void stop();
+
+    // same as the bins_*_create() functions, which they fall back to. the
+    //   bins may come out in READY, so set them to NULL before dropping
+    //   them unused
+    GstElement *audioenc(const QString &codec, int id, int rate, int size, int channels, const POpusOptions &opus);
+    GstElement *videoenc(const QString &codec, int id, int maxkbps, const QSize &size, bool realtime);
+    GstElement *audiodec(const QString &codec, const POpusOptions &opus);
+    GstElement *videodec(const QString &codec);
+
+    Stats stats() const;
+
+private:
+    class Entry {
+    public:
+        std::function<GstElement *()> make;
+        QList<GstElement *>           bins;
+    };
+
+    int                   size_;
+    QMutex                mutex_;
+    QHash<QString, Entry> entries_;
+    GMainContext         *context_ = nullptr;
+    GSource              *refill_  = nullptr;
+    std::atomic<quint64>  hits_ { 0 };
+    std::atomic<quint64>  misses_ { 0 };
+
+    BinPool();
+
+    GstElement *take(const QString &key, const std::function<GstElement *()> &make);
+    void        scheduleRefill();
+    gboolean    refill();
+
+    static gboolean cb_refill(gpointer data);
+};
+
+} // namespace PsiMedia
+
+#endif // PSIMEDIA_BINPOOL_H
@@ -20,8 +20,11 @@
 
 #include "bins.h"
 
+#include "codecs.h"
+
 #include <QSize>
 #include <QString>
+#include <QThread>
 #include <cstdio>
 #include <gst/audio/audio-channels.h>
 #include <gst/gst.h>
@@ -40,170 +43,23 @@ static int get_rtp_latency()
         return DEFAULT_RTP_LATENCY;
 }
 
-static GstElement *audio_codec_to_enc_element(const QString &name)
-{
-    QString ename;
-    if (name == "opus") {
-        auto e = gst_element_factory_make("opusenc", "opus-encoder");
-        gst_util_set_object_arg(G_OBJECT(e), "audio-type", "voice");
-        gst_util_set_object_arg(G_OBJECT(e), "bitrate-type", "vbr");
-        return e;
-    } else if (name == "vorbis")
-        ename = "vorbisenc";
-    else if (name == "pcmu")
-        ename = "mulawenc";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *audio_codec_to_dec_element(const QString &name)
-{
-    QString ename;
-    if (name == "opus")
-        ename = "opusdec";
-    else if (name == "vorbis")
-        ename = "vorbisdec";
-    else if (name == "pcmu")
-        ename = "mulawdec";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *audio_codec_to_rtppay_element(const QString &name)
-{
-    QString ename;
-    if (name == "opus")
-        ename = "rtpopuspay";
-    else if (name == "vorbis")
-        ename = "rtpvorbispay";
-    else if (name == "pcmu")
-        ename = "rtppcmupay";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *audio_codec_to_rtpdepay_element(const QString &name)
-{
-    QString ename;
-    if (name == "opus")
-        ename = "rtpopusdepay";
-    else if (name == "vorbis")
-        ename = "rtpvorbisdepay";
-    else if (name == "pcmu")
-        ename = "rtppcmudepay";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *video_codec_to_enc_element(const QString &name)
-{
-    QString ename;
-    if (name == QLatin1String("vp8"))
-        ename = QLatin1String("vp8enc");
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *video_codec_to_dec_element(const QString &name)
-{
-    QString ename;
-    if (name == QLatin1String("vp8"))
-        ename = QLatin1String("vp8dec");
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *video_codec_to_rtppay_element(const QString &name)
-{
-    QString ename;
-    if (name == "vp8")
-        ename = "rtpvp8pay";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static GstElement *video_codec_to_rtpdepay_element(const QString &name)
-{
-    QString ename;
-    if (name == "vp8")
-        ename = "rtpvp8depay";
-    else
-        return nullptr;
-
-    return gst_element_factory_make(ename.toLatin1().data(), nullptr);
-}
-
-static bool audio_codec_get_send_elements(const QString &name, GstElement **enc, GstElement **rtppay)
+// the encoder and payloader (send) or decoder and depayloader of a codec
+static bool codec_get_elements(const CodecDesc *codec, bool send, GstElement **element, GstElement **rtpElement)
 {
-    GstElement *eenc = audio_codec_to_enc_element(name);
-    if (!eenc)
+    if (!codec)
         return false;
-    GstElement *epay = audio_codec_to_rtppay_element(name);
-    if (!epay) {
-        g_object_unref(G_OBJECT(eenc));
-    }
-
-    *enc    = eenc;
-    *rtppay = epay;
-    return true;
-}
 
-static bool audio_codec_get_recv_elements(const QString &name, GstElement **dec, GstElement **rtpdepay)
-{
-    GstElement *edec = audio_codec_to_dec_element(name);
-    if (!edec)
+    GstElement *e = codecs_createElement(codec, send ? CodecDesc::Encoder : CodecDesc::Decoder);
+    if (!e)
         return false;
-    GstElement *edepay = audio_codec_to_rtpdepay_element(name);
-    if (!edepay) {
-        g_object_unref(G_OBJECT(edec));
-    }
-
-    *dec      = edec;
-    *rtpdepay = edepay;
-    return true;
-}
-
-static bool video_codec_get_send_elements(const QString &name, GstElement **enc, GstElement **rtppay)
-{
-    GstElement *eenc = video_codec_to_enc_element(name);
-    if (!eenc)
+    GstElement *rtp = codecs_createElement(codec, send ? CodecDesc::Payloader : CodecDesc::Depayloader);
+    if (!rtp) {
+        g_object_unref(G_OBJECT(e));
         return false;
-    GstElement *epay = video_codec_to_rtppay_element(name);
-    if (!epay) {
-        g_object_unref(G_OBJECT(eenc));
     }
 
-    *enc    = eenc;
-    *rtppay = epay;
-    return true;
-}
-
-static bool video_codec_get_recv_elements(const QString &name, GstElement **dec, GstElement **rtpdepay)
-{
-    GstElement *edec = video_codec_to_dec_element(name);
-    if (!edec)
-        return false;
-    GstElement *edepay = video_codec_to_rtpdepay_element(name);
-    if (!edepay) {
-        g_object_unref(G_OBJECT(edec));
-    }
-
-    *dec      = edec;
-    *rtpdepay = edepay;
+    *element    = e;
+    *rtpElement = rtp;
     return true;
 }
 
@@ -290,19 +146,47 @@ GstElement *bins_videoprep_create(const QSize &size, int fps, bool is_live)
     return bin;
 }
 
+// name of the factory an element was made from
+static const gchar *factory_name(GstElement *e)
+{
+    GstElementFactory *factory = gst_element_get_factory(e);
+    return factory ? gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)) : "";
+}
+
+// opusenc only takes these, the closest one not longer than ms is used
+static const char *opus_frame_size(int ms)
+{
+    if (ms >= 60)
+        return "60";
+    if (ms >= 40)
+        return "40";
+    if (ms >= 20)
+        return "20";
+    if (ms >= 10)
+        return "10";
+    if (ms >= 5)
+        return "5";
+    return "2.5";
+}
+
 GstElement *bins_audioenc_create(const QString &codec, int id, int rate, int size, int channels)
 {
-    bool variableRate = (codec == QLatin1String("opus")); // opus supports variable bitrate and resampling on its own
-    GstElement *bin   = gst_bin_new("audioencbin");
+    const CodecDesc *desc = codecs_find(CodecDesc::Audio, codec);
 
     GstElement *audioenc    = nullptr;
     GstElement *audiortppay = nullptr;
-    if (!audio_codec_get_send_elements(codec, &audioenc, &audiortppay))
+    if (!codec_get_elements(desc, true, &audioenc, &audiortppay))
         return nullptr;
 
+    bool        variableRate = desc->resamples; // e.g. opus does variable bitrate and resampling on its own
+    GstElement *bin          = gst_bin_new("audioencbin");
+
     if (id != -1)
         g_object_set(G_OBJECT(audiortppay), "pt", id, NULL);
 
+    gst_element_set_name(audioenc, "audioenc");
+    gst_element_set_name(audiortppay, "audiortppay");
+
     GstElement *audioconvert  = gst_element_factory_make("audioconvert", nullptr);
     GstElement *audioresample = nullptr;
     if (!variableRate) {
@@ -358,25 +242,113 @@ GstElement *bins_audioenc_create(const QString &codec, int id, int rate, int siz
     return bin;
 }
 
-GstElement *bins_videoenc_create(const QString &codec, int id, int maxkbps)
+void bins_audioenc_configure(GstElement *encbin, const POpusOptions &opus)
 {
-    GstElement *bin = gst_bin_new("videoencbin");
+    GstElement *enc = gst_bin_get_by_name(GST_BIN(encbin), "audioenc");
+    if (!enc)
+        return;
+
+    if (qstrcmp(factory_name(enc), "opusenc") == 0) {
+        if (opus.bitrate > 0)
+            g_object_set(G_OBJECT(enc), "bitrate", qBound(4, opus.bitrate, 650) * 1000, NULL);
+        if (opus.frameSize > 0)
+            gst_util_set_object_arg(G_OBJECT(enc), "frame-size", opus_frame_size(opus.frameSize));
+        if (opus.complexity >= 0)
+            g_object_set(G_OBJECT(enc), "complexity", qBound(0, opus.complexity, 10), NULL);
+        int loss = opus.expectedLoss < 0 ? OPUS_FEC_LOSS : qMin(opus.expectedLoss, 100);
+        g_object_set(G_OBJECT(enc), "inband-fec", gboolean(opus.inbandFec), "packet-loss-percentage",
+                     opus.inbandFec ? loss : 0, "dtx", gboolean(opus.dtx), NULL);
+
+        // silence comes out of the encoder as tiny frames, the payloader
+        //   can leave those out (since 1.20)
+        GstElement *pay = gst_bin_get_by_name(GST_BIN(encbin), "audiortppay");
+        if (pay) {
+            if (g_object_class_find_property(G_OBJECT_GET_CLASS(pay), "dtx"))
+                g_object_set(G_OBJECT(pay), "dtx", gboolean(opus.dtx), NULL);
+            gst_object_unref(pay);
+        }
+    }
+
+    gst_object_unref(enc);
+}
 
-    GstElement *videoenc    = nullptr;
-    GstElement *videortppay = nullptr;
-    if (!video_codec_get_send_elements(codec, &videoenc, &videortppay))
+namespace {
+
+    // the unit each encoder takes its bitrate in
+    class BitrateProp {
+    public:
+        const char *factory;
+        const char *name;
+        int         bitsPerUnit;
+    };
+
+    const BitrateProp bitrateProps[] = {
+        { "vp8enc", "target-bitrate", 1 },
+        { "vp9enc", "target-bitrate", 1 },
+        { "x264enc", "bitrate", 1000 },
+        { "openh264enc", "bitrate", 1 },
+        { "svtav1enc", "target-bitrate", 1000 },
+        { "rav1enc", "bitrate", 1 },
+        { "av1enc", "target-bitrate", 1000 },
+        { "avenc_h263p", "bitrate", 1 },
+    };
+
+    // libvpx defaults are meant for encoding files: a deadline of a
+    //   second, a 25 frame lookahead and one thread. for a call, encode
+    //   each frame as it comes, fast enough for the size and the cores we
+    //   have, and keep the rate buffer short so the bitrate can't burst
+    void vp8_set_realtime(GstElement *enc, const QSize &size)
+    {
+        int  cores = QThread::idealThreadCount();
+        bool hd    = size.width() * size.height() >= 1280 * 720;
+
+        int cpuUsed = 4;
+        if (hd)
+            cpuUsed += 4;
+        if (cores <= 2)
+            cpuUsed += 4;
+
+        // each thread works on a token partition, so they go together.
+        //   partitions are given as log2
+        int threads    = qBound(1, cores - 1, hd ? 4 : 2);
+        int partitions = qMin(threads - 1, 2);
+
+        g_object_set(G_OBJECT(enc), "deadline", gint64(1), "cpu-used", cpuUsed, "threads", threads,
+                     "token-partitions", partitions, "error-resilient", 1, "lag-in-frames", 0, "end-usage", 1,
+                     "keyframe-max-dist", 150, "buffer-size", 1000, "buffer-initial-size", 500, "buffer-optimal-size",
+                     600, NULL);
+    }
+
+}
+
+GstElement *bins_videoenc_create(const QString &codec, int id, int maxkbps, const QSize &size, bool realtime)
+{
+    const CodecDesc *desc        = codecs_find(CodecDesc::Video, codec);
+    GstElement      *videoenc    = nullptr;
+    GstElement      *videortppay = nullptr;
+    if (!codec_get_elements(desc, true, &videoenc, &videortppay))
         return nullptr;
 
+    GstElement *bin = gst_bin_new("videoencbin");
+
     if (id != -1)
         g_object_set(G_OBJECT(videortppay), "pt", id, NULL);
 
+    gst_element_set_name(videoenc, "videoenc");
+
     GstElement *videoconvert = gst_element_factory_make("videoconvert", nullptr);
 
     gst_bin_add(GST_BIN(bin), videoconvert);
     gst_bin_add(GST_BIN(bin), videoenc);
     gst_bin_add(GST_BIN(bin), videortppay);
 
-    gst_element_link_many(videoconvert, videoenc, videortppay, NULL);
+    gst_element_link(videoconvert, videoenc);
+    if (desc->encoderCaps) {
+        GstCaps *caps = gst_caps_from_string(desc->encoderCaps);
+        gst_element_link_filtered(videoenc, videortppay, caps);
+        gst_caps_unref(caps);
+    } else
+        gst_element_link(videoenc, videortppay);
 
     GstPad *pad;
 
@@ -388,31 +360,65 @@ GstElement *bins_videoenc_create(const QString &codec, int id, int maxkbps)
     gst_element_add_pad(bin, gst_ghost_pad_new("src", pad));
     gst_object_unref(GST_OBJECT(pad));
 
+    bins_videoenc_configure(bin, maxkbps, size, realtime);
+
     return bin;
 }
 
-GstElement *bins_audiodec_create(const QString &codec)
+void bins_videoenc_configure(GstElement *encbin, int maxkbps, const QSize &size, bool realtime)
 {
-    GstElement *bin = gst_bin_new("audiodecbin");
+    GstElement *enc = gst_bin_get_by_name(GST_BIN(encbin), "videoenc");
+    if (!enc)
+        return;
+
+    const gchar *name = factory_name(enc);
+
+    if (realtime && qstrcmp(name, "vp8enc") == 0)
+        vp8_set_realtime(enc, size);
+
+    if (maxkbps > 0) {
+        for (const BitrateProp &b : bitrateProps) {
+            if (qstrcmp(name, b.factory) != 0)
+                continue;
+            qint64 bits = qint64(maxkbps) * 1000 / b.bitsPerUnit;
+            gst_util_set_object_arg(G_OBJECT(enc), b.name, QByteArray::number(bits).data());
+            break;
+        }
+    }
+
+    gst_object_unref(enc);
+}
+
+// the jitter buffers live in here, so this is where the latency goes
+GstElement *bins_rtpbin_create(const char *name)
+{
+    GstElement *rtpbin = gst_element_factory_make("rtpbin", name);
+    if (!rtpbin)
+        return nullptr;
 
+    g_object_set(G_OBJECT(rtpbin), "latency", (unsigned int)get_rtp_latency(), NULL);
+    return rtpbin;
+}
+
+GstElement *bins_audiodec_create(const QString &codec)
+{
     GstElement *audiodec      = nullptr;
     GstElement *audiortpdepay = nullptr;
-    if (!audio_codec_get_recv_elements(codec, &audiodec, &audiortpdepay))
+    if (!codec_get_elements(codecs_find(CodecDesc::Audio, codec), false, &audiodec, &audiortpdepay))
         return nullptr;
 
-    GstElement *audiortpjitterbuffer = gst_element_factory_make("rtpjitterbuffer", nullptr);
+    GstElement *bin = gst_bin_new("audiodecbin");
+
+    gst_element_set_name(audiodec, "audiodec");
 
-    gst_bin_add(GST_BIN(bin), audiortpjitterbuffer);
     gst_bin_add(GST_BIN(bin), audiortpdepay);
     gst_bin_add(GST_BIN(bin), audiodec);
 
-    gst_element_link_many(audiortpjitterbuffer, audiortpdepay, audiodec, NULL);
-
-    g_object_set(G_OBJECT(audiortpjitterbuffer), "latency", (unsigned int)get_rtp_latency(), NULL);
+    gst_element_link_many(audiortpdepay, audiodec, NULL);
 
     GstPad *pad;
 
-    pad = gst_element_get_static_pad(audiortpjitterbuffer, "sink");
+    pad = gst_element_get_static_pad(audiortpdepay, "sink");
     gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad));
     gst_object_unref(GST_OBJECT(pad));
 
@@ -423,28 +429,37 @@ GstElement *bins_audiodec_create(const QString &codec)
     return bin;
 }
 
-GstElement *bins_videodec_create(const QString &codec)
+void bins_audiodec_configure(GstElement *decbin, const POpusOptions &opus)
 {
-    GstElement *bin = gst_bin_new("videodecbin");
+    GstElement *dec = gst_bin_get_by_name(GST_BIN(decbin), "audiodec");
+    if (!dec)
+        return;
 
+    // conceal lost packets rather than play silence, and with fec recover
+    //   them from the next packet where the peer sent the redundancy
+    if (qstrcmp(factory_name(dec), "opusdec") == 0)
+        g_object_set(G_OBJECT(dec), "plc", TRUE, "use-inband-fec", gboolean(opus.inbandFec), NULL);
+
+    gst_object_unref(dec);
+}
+
+GstElement *bins_videodec_create(const QString &codec)
+{
     GstElement *videodec      = nullptr;
     GstElement *videortpdepay = nullptr;
-    if (!video_codec_get_recv_elements(codec, &videodec, &videortpdepay))
+    if (!codec_get_elements(codecs_find(CodecDesc::Video, codec), false, &videodec, &videortpdepay))
         return nullptr;
 
-    GstElement *videortpjitterbuffer = gst_element_factory_make("rtpjitterbuffer", nullptr);
+    GstElement *bin = gst_bin_new("videodecbin");
 
-    gst_bin_add(GST_BIN(bin), videortpjitterbuffer);
     gst_bin_add(GST_BIN(bin), videortpdepay);
     gst_bin_add(GST_BIN(bin), videodec);
 
-    gst_element_link_many(videortpjitterbuffer, videortpdepay, videodec, NULL);
-
-    g_object_set(G_OBJECT(videortpjitterbuffer), "latency", (unsigned int)get_rtp_latency(), NULL);
+    gst_element_link_many(videortpdepay, videodec, NULL);
 
     GstPad *pad;
 
-    pad = gst_element_get_static_pad(videortpjitterbuffer, "sink");
+    pad = gst_element_get_static_pad(videortpdepay, "sink");
     gst_element_add_pad(bin, gst_ghost_pad_new("sink", pad));
     gst_object_unref(GST_OBJECT(pad));
 
@@ -455,4 +470,18 @@ GstElement *bins_videodec_create(const QString &codec)
     return bin;
 }
 
+void bins_rtppay_set_pt(GstElement *encbin, int id)
+{
+    GstPad *pad    = gst_element_get_static_pad(encbin, "src");
+    GstPad *target = gst_ghost_pad_get_target(GST_GHOST_PAD(pad));
+    gst_object_unref(GST_OBJECT(pad));
+    if (!target)
+        return;
+
+    GstElement *rtppay = gst_pad_get_parent_element(target);
+    gst_object_unref(GST_OBJECT(target));
+    g_object_set(G_OBJECT(rtppay), "pt", id, NULL);
+    gst_object_unref(GST_OBJECT(rtppay));
+}
+
 }
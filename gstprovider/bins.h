@@ -28,13 +28,29 @@ class QSize;
 
 namespace PsiMedia {
 
+class POpusOptions;
+
 GstElement *bins_videoprep_create(const QSize &size, int fps, bool is_live);
 
 GstElement *bins_audioenc_create(const QString &codec, int id, int rate, int size, int channels);
-GstElement *bins_videoenc_create(const QString &codec, int id, int maxkbps);
+GstElement *bins_videoenc_create(const QString &codec, int id, int maxkbps, const QSize &size, bool realtime);
+GstElement *bins_rtpbin_create(const char *name);
 GstElement *bins_audiodec_create(const QString &codec);
 GstElement *bins_videodec_create(const QString &codec);
 
+// sets the payload type of an audioenc or videoenc bin
+void bins_rtppay_set_pt(GstElement *encbin, int id);
+
+// applies the options to the opus encoder or decoder of a bin, other
+//   codecs are left alone
+void bins_audioenc_configure(GstElement *encbin, const POpusOptions &opus);
+void bins_audiodec_configure(GstElement *decbin, const POpusOptions &opus);
+
+// sets the bitrate of a videoenc bin, -1 keeps the encoder's default.
+//   realtime tunes the encoder for a call at the given size rather than
+//   leaving the defaults, which are meant for encoding files
+void bins_videoenc_configure(GstElement *encbin, int maxkbps, const QSize &size, bool realtime);
+
 }
 
 #endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "codecs.h"
+
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include <iterator>
+
+// the h264 we send is constrained baseline, at the level the largest of
+//   the advertised modes (1280x720@30) takes, 3.1
+#define H264_SEND_LEVEL 31
+
+namespace PsiMedia {
+
+namespace {
+
+    // the profile_idc, constraint flags and level_idc of a
+    //   profile-level-id, as in rfc 6184 8.1. without one it's baseline
+    //   at level 1
+    struct H264Profile {
+        int profile     = 66;
+        int constraints = 0;
+        int level       = 10;
+    };
+
+    bool h264ParseProfile(const PPayloadInfo &info, H264Profile *out)
+    {
+        for (const PPayloadInfo::Parameter &p : info.parameters) {
+            if (p.name != "profile-level-id")
+                continue;
+            bool ok;
+            uint id = p.value.toUInt(&ok, 16);
+            if (!ok || p.value.length() != 6)
+                return false;
+            out->profile     = int(id >> 16);
+            out->constraints = int((id >> 8) & 0xff);
+            out->level       = int(id & 0xff);
+            // level 1b is written as 1.1 with constraint_set3 in these
+            //   profiles, so it goes just under 1.1
+            if (out->level == 11 && (out->constraints & 0x10)
+                && (out->profile == 66 || out->profile == 77 || out->profile == 88))
+                out->level = 9;
+        }
+        return true;
+    }
+
+    // as the caps of the decoders name it, nullptr if we don't know it
+    const char *h264ProfileName(const H264Profile &p)
+    {
+        switch (p.profile) {
+        case 66:
+            return (p.constraints & 0x40) ? "constrained-baseline" : "baseline";
+        case 77:
+            return "main";
+        case 88:
+            return "extended";
+        case 100:
+            return "high";
+        case 110:
+            return "high-10";
+        case 122:
+            return "high-4:2:2";
+        case 244:
+            return "high-4:4:4";
+        default:
+            return nullptr;
+        }
+    }
+
+    QByteArray h264LevelName(int level)
+    {
+        if (level == 9)
+            return "1b";
+        if (level % 10 == 0)
+            return QByteArray::number(level / 10);
+        return QByteArray::number(level / 10) + '.' + QByteArray::number(level % 10);
+    }
+
+    // rfc 6184. the depayloader can't do the interleaved mode, and what
+    //   we send is fragmented, which takes mode 1. when sending, the
+    //   profile-level-id says what the peer decodes: any of the profiles
+    //   above plays our constrained baseline, as long as the level is at
+    //   least ours. when receiving, it says what the peer sends, which
+    //   the decoder we have has to take
+    bool h264Accepts(const PPayloadInfo &info, bool sending, GstElementFactory *decoder)
+    {
+        QString mode = "0";
+        for (const PPayloadInfo::Parameter &p : info.parameters) {
+            if (p.name == "packetization-mode")
+                mode = p.value;
+        }
+        if (mode != "1" && (sending || mode != "0"))
+            return false;
+
+        H264Profile profile;
+        if (!h264ParseProfile(info, &profile))
+            return false;
+        const char *name = h264ProfileName(profile);
+        if (!name)
+            return false;
+
+        if (sending)
+            return profile.level >= H264_SEND_LEVEL;
+
+        if (!decoder)
+            return false;
+        GstCaps *caps = gst_caps_new_simple("video/x-h264", "profile", G_TYPE_STRING, name, "level", G_TYPE_STRING,
+                                            h264LevelName(profile.level).data(), nullptr);
+        bool     ok   = gst_element_factory_can_sink_any_caps(decoder, caps);
+        gst_caps_unref(caps);
+        return ok;
+    }
+
+    // in order of preference among codecs of the same cost
+    const CodecDesc codecTable[] = {
+        // older peers announce opus at its sample rate, so the clock rate
+        //   is left unchecked
+        { "opus", "OPUS", CodecDesc::Audio, 0, { "opusenc", "opusdec", "rtpopuspay", "rtpopusdepay" }, nullptr, 2, true,
+          "8000/16/1 16000/16/1", nullptr },
+        { "vorbis", "VORBIS", CodecDesc::Audio, 0, { "vorbisenc", "vorbisdec", "rtpvorbispay", "rtpvorbisdepay" },
+          nullptr, 3, false, nullptr, nullptr },
+        { "pcmu", "PCMU", CodecDesc::Audio, 8000, { "mulawenc", "mulawdec", "rtppcmupay", "rtppcmudepay" }, nullptr, 1,
+          false, nullptr, nullptr },
+        { "vp8", "VP8", CodecDesc::Video, 90000, { "vp8enc", "vp8dec", "rtpvp8pay", "rtpvp8depay" }, nullptr, 4, false,
+          "640x480@30 1280x720@30", nullptr },
+        { "h264", "H264", CodecDesc::Video, 90000,
+          { "x264enc openh264enc", "avdec_h264 openh264dec", "rtph264pay", "rtph264depay" },
+          "video/x-h264,profile=constrained-baseline", 4, false, "640x480@30 1280x720@30", h264Accepts },
+        { "vp9", "VP9", CodecDesc::Video, 90000, { "vp9enc", "vp9dec", "rtpvp9pay", "rtpvp9depay" }, nullptr, 6, false,
+          "640x480@30 1280x720@30", nullptr },
+        // the encoder is the most expensive by far, so 720p isn't advertised
+        { "av1", "AV1", CodecDesc::Video, 90000,
+          { "svtav1enc rav1enc av1enc", "dav1ddec av1dec", "rtpav1pay", "rtpav1depay" }, nullptr, 8, false,
+          "640x480@30", nullptr },
+        { "h263p", "H263-1998", CodecDesc::Video, 90000,
+          { "avenc_h263p", "avdec_h263", "rtph263ppay", "rtph263pdepay" }, nullptr, 3, false, nullptr, nullptr },
+    };
+
+    // "name=value ..." on top of a factory's defaults, and the property
+    //   that takes its number of threads, if it has one. the encoders are
+    //   set up for real time: no lookahead or b-frames, keyframes every
+    //   two seconds, and threads over slices, tiles or rows rather than
+    //   frames
+    struct FactoryProps {
+        const char *factory;
+        const char *props;
+        const char *threads;
+    };
+
+    const FactoryProps factoryProps[] = {
+        { "opusenc", "audio-type=voice bitrate-type=vbr", nullptr },
+        { "x264enc", "tune=zerolatency speed-preset=ultrafast sliced-threads=true key-int-max=60", "threads" },
+        { "openh264enc", "usage-type=camera complexity=low gop-size=60", "multi-thread" },
+        { "avdec_h264", "thread-type=slice", nullptr },
+        { "rtph264pay", "config-interval=-1 aggregate-mode=zero-latency", nullptr },
+        { "vp9enc",
+          "deadline=1 cpu-used=7 lag-in-frames=0 end-usage=cbr keyframe-max-dist=60 row-mt=true tile-columns=2",
+          "threads" },
+        { "svtav1enc", "preset=12 intra-period-length=60", "logical-processors" },
+        { "rav1enc", "speed-preset=10 low-latency=true max-key-frame-interval=60 tiles=4", "threads" },
+        { "av1enc", "usage-profile=realtime cpu-used=8 lag-in-frames=0 end-usage=cbr keyframe-max-dist=60 row-mt=true "
+                    "tile-columns=2",
+          "threads" },
+    };
+
+    // a core is left to capture, audio and the network, and more than 8
+    //   threads don't pay off at these sizes
+    int encoderThreads() { return qBound(1, QThread::idealThreadCount() - 1, 8); }
+
+    constexpr int codecCount = int(std::size(codecTable));
+
+    // the factories are kept for the life of the process
+    class Registry {
+    public:
+        GstElementFactory       *factories[codecCount][4] {};
+        QList<const CodecDesc *> available[2];
+
+        Registry()
+        {
+            for (int n = 0; n < codecCount; ++n) {
+                const CodecDesc &c    = codecTable[n];
+                bool             have = true;
+                for (int e = 0; e < 4; ++e) {
+                    const QStringList names = QString::fromLatin1(c.elements[e]).split(' ');
+                    for (const QString &name : names) {
+                        factories[n][e] = gst_element_factory_find(name.toLatin1().data());
+                        if (factories[n][e])
+                            break;
+                    }
+                    if (!factories[n][e])
+                        have = false;
+                }
+                if (have)
+                    available[c.media] += &c;
+            }
+
+            for (QList<const CodecDesc *> &list : available)
+                std::stable_sort(list.begin(), list.end(),
+                                 [](const CodecDesc *a, const CodecDesc *b) { return a->cost < b->cost; });
+        }
+    };
+
+    const Registry &registry()
+    {
+        static const Registry r;
+        return r;
+    }
+
+    void setProperties(GstElement *e, const char *props)
+    {
+        if (!props)
+            return;
+
+        const QStringList list = QString::fromLatin1(props).split(' ');
+        for (const QString &p : list) {
+            int at = int(p.indexOf('='));
+            if (at < 1)
+                continue;
+            QByteArray name = p.left(at).toLatin1();
+            if (g_object_class_find_property(G_OBJECT_GET_CLASS(e), name.data()))
+                gst_util_set_object_arg(G_OBJECT(e), name.data(), p.mid(at + 1).toLatin1().data());
+        }
+    }
+
+}
+
+void codecs_probe() { registry(); }
+
+QList<const CodecDesc *> codecs_available(CodecDesc::Media media) { return registry().available[media]; }
+
+const CodecDesc *codecs_find(CodecDesc::Media media, const QString &name)
+{
+    for (const CodecDesc *c : registry().available[media]) {
+        if (name == QLatin1String(c->name))
+            return c;
+    }
+    return nullptr;
+}
+
+const CodecDesc *codecs_findPayload(CodecDesc::Media media, const PPayloadInfo &info, bool sending)
+{
+    for (const CodecDesc *c : registry().available[media]) {
+        if (info.name.compare(QLatin1String(c->rtpName), Qt::CaseInsensitive) == 0
+            && (c->clockRate == 0 || info.clockrate == c->clockRate)
+            && (!c->accepts || c->accepts(info, sending, registry().factories[c - codecTable][CodecDesc::Decoder])))
+            return c;
+    }
+    return nullptr;
+}
+
+GstElement *codecs_createElement(const CodecDesc *codec, CodecDesc::Element which)
+{
+    GstElementFactory *factory = registry().factories[codec - codecTable][which];
+    if (!factory)
+        return nullptr;
+
+    GstElement *e = gst_element_factory_create(factory, nullptr);
+    if (!e)
+        return nullptr;
+
+    const char *name = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+    for (const FactoryProps &f : factoryProps) {
+        if (qstrcmp(f.factory, name) != 0)
+            continue;
+        setProperties(e, f.props);
+        if (f.threads && g_object_class_find_property(G_OBJECT_GET_CLASS(e), f.threads))
+            gst_util_set_object_arg(G_OBJECT(e), f.threads, QByteArray::number(encoderThreads()).data());
+        break;
+    }
+    return e;
+}
+
+}
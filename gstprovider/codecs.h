@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_CODECS_H
+#define PSIMEDIA_CODECS_H
+
+#include "psimediaprovider.h"
+
+#include <QList>
+#include <gst/gstelement.h>
+#include <gst/gstelementfactory.h>
+
+namespace PsiMedia {
+
+// what it takes to carry a codec over rtp. supporting another codec comes
+//   down to adding its entry to the table in codecs.cpp
+class CodecDesc {
+public:
+    enum Media { Audio, Video };
+    enum Element { Encoder, Decoder, Payloader, Depayloader };
+
+    const char *name;        // lowercase, as in PAudioParams/PVideoParams
+    const char *rtpName;     // encoding name, as in PPayloadInfo
+    Media       media;
+    int         clockRate;   // rtp clock rate, 0 if it isn't checked
+    const char *elements[4]; // factory names, indexed by Element. alternatives
+                             //   may be listed, the first installed is used
+    const char *encoderCaps; // forced between encoder and payloader, if set
+    int         cost;        // rough cpu cost of a stream, lower is cheaper
+    bool        resamples;   // the encoder takes any sample rate
+    const char *modes;       // advertised, "rate/size/channels ..." or "WxH@fps ..."
+
+    // whether a payload type of this codec can be used, beyond its name
+    //   and clock rate, given the decoder that was found. nullptr if any
+    //   will do
+    bool (*accepts)(const PPayloadInfo &info, bool sending, GstElementFactory *decoder);
+};
+
+// looks the table up in the gstreamer registry. this is done once per
+//   process, later calls return right away. gstreamer must be initialized
+void codecs_probe();
+
+// the codecs whose elements are all installed, cheapest first
+QList<const CodecDesc *> codecs_available(CodecDesc::Media media);
+
+// nullptr if the codec is unknown or not installed
+const CodecDesc *codecs_find(CodecDesc::Media media, const QString &name);
+const CodecDesc *codecs_findPayload(CodecDesc::Media media, const PPayloadInfo &info, bool sending = false);
+
+// made from the factory found when probing, with the properties set that
+//   codecs.cpp keeps for that factory
+GstElement *codecs_createElement(const CodecDesc *codec, CodecDesc::Element which);
+
+}
+
+#endif // PSIMEDIA_CODECS_H
@@ -547,18 +547,18 @@ QList<GstDevice> DeviceMonitor::devices(PDevice::Type type)
     return ret;
 }
 
-GstDevice *DeviceMonitor::device(const QString &id)
+std::optional<GstDevice> DeviceMonitor::device(const QString &id)
 {
-    // to be called from gst thread
-    auto it = d->_monitorDevices.find(id);
+    QMutexLocker locker(&d->devListMutex);
+    auto         it = d->_monitorDevices.find(id);
     if (it != d->_monitorDevices.end()) {
-        return &it.value();
+        return it.value();
     }
     it = d->_platformDevices.find(id);
     if (it != d->_platformDevices.end()) {
-        return &it.value();
+        return it.value();
     }
-    return nullptr;
+    return std::nullopt;
 }
 
 GstElement *devices_makeElement(const QString &id, PDevice::Type type, QSize *captureSize)
@@ -28,6 +28,7 @@
 #include <gst/gstelement.h>
 
 #include <memory>
+#include <optional>
 
 class QSize;
 
@@ -83,7 +84,9 @@ public:
 
     void             start();
     QList<GstDevice> devices(PDevice::Type type);
-    GstDevice       *device(const QString &id);
+
+    // a copy, as sessions look devices up from their own threads
+    std::optional<GstDevice> device(const QString &id);
 };
 
 GstElement *devices_makeElement(const QString &id, PDevice::Type type, QSize *captureSize = nullptr);
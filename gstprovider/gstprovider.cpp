@@ -21,6 +21,7 @@
 
 #include "psimediaprovider.h"
 
+#include "binpool.h"
 #include "devices.h"
 #include "gstaudiorecordercontext.h"
 #include "gstfeaturescontext.h"
@@ -28,58 +29,95 @@
 #include "gstrtpsessioncontext.h"
 #include "gstthread.h"
 
+#include <QWaitCondition>
 #include <QtPlugin>
+#include <atomic>
 
 namespace PsiMedia {
 
-//----------------------------------------------------------------------------
-// GstProvider
-//----------------------------------------------------------------------------
-GstProvider::GstProvider(const QVariantMap &params)
+static int get_session_loops()
 {
-    // qDebug("GstProvider::GstProvider thread=%p", QThread::currentThreadId());
-    gstEventLoopThread.setObjectName("GstEventLoop");
+    QString val = QString::fromLatin1(qgetenv("PSI_GST_SESSION_LOOPS"));
+    if (!val.isEmpty())
+        return qMax(val.toInt(), 0);
+    else
+        return qMax(QThread::idealThreadCount(), 1);
+}
 
-    auto resourcePath = params.value("resourcePath").toString();
-    gstEventLoop      = new GstMainLoop(resourcePath);
-    deviceMonitor     = new DeviceMonitor(gstEventLoop);
-    gstEventLoop->moveToThread(&gstEventLoopThread);
+// runs the glib loop of mainLoop on thread, and waits until it is up.
+//   returns false if it failed to start, in which case thread has finished
+static bool startLoop(QThread *thread, GstMainLoop *mainLoop)
+{
+    mainLoop->moveToThread(thread);
 
     QMutex waitMutex;
     waitMutex.lock();
     QWaitCondition   wait;
     std::atomic_bool success { false };
-    connect(
-        &gstEventLoopThread, &QThread::started, gstEventLoop,
-        [this, &wait, &success]() {
-            Q_ASSERT(QThread::currentThread() == &gstEventLoopThread);
-            // connect(&gstEventLoopThread, &QThread::finished, gstEventLoop, &QObject::deleteLater);
-            connect(gstEventLoop, &GstMainLoop::started, [&wait, &success]() {
+    QObject::connect(
+        thread, &QThread::started, mainLoop,
+        [thread, mainLoop, &wait, &success]() {
+            Q_ASSERT(QThread::currentThread() == thread);
+            // connect(thread, &QThread::finished, mainLoop, &QObject::deleteLater);
+            QObject::connect(mainLoop, &GstMainLoop::started, [&wait, &success]() {
                 // faired by timer from gst loop. means complete success in starting.
                 success.store(true);
                 wait.wakeOne();
             });
             // do any custom stuff here before glib event loop started. it's already initialized
-            if (!gstEventLoop->start()) { // this call won't return while event loop is still running
+            if (!mainLoop->start()) { // this call won't return while event loop is still running
                 qWarning("glib event loop failed to initialize");
-                gstEventLoopThread.exit(1); // noop if ~GstProvider() was called first?
+                thread->exit(1); // noop if ~GstProvider() was called first?
                 wait.wakeOne();
                 return;
             }
         },
         Qt::QueuedConnection);
-    gstEventLoopThread.start();
+    thread->start();
     wait.wait(&waitMutex);
     waitMutex.unlock();
     if (!success.load()) {
-        gstEventLoopThread.wait();
+        thread->wait();
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+// GstProvider
+//----------------------------------------------------------------------------
+GstProvider::GstProvider(const QVariantMap &params)
+{
+    // qDebug("GstProvider::GstProvider thread=%p", QThread::currentThreadId());
+    gstEventLoopThread.setObjectName("GstEventLoop");
+
+    resourcePath    = params.value("resourcePath").toString();
+    maxSessionLoops = get_session_loops();
+    gstEventLoop    = new GstMainLoop(resourcePath);
+    deviceMonitor   = new DeviceMonitor(gstEventLoop);
+
+    if (!startLoop(&gstEventLoopThread, gstEventLoop)) {
         delete gstEventLoop; // will null it coz QPointer
+        return;
     }
+
+    BinPool::instance()->start(gstEventLoop->mainContext());
 }
 
 GstProvider::~GstProvider()
 {
     if (gstEventLoopThread.isRunning()) {
+        BinPool::instance()->stop();
+
+        for (SessionLoop *l : std::as_const(sessionLoops)) {
+            l->loop->stop();
+            l->thread.quit();
+            l->thread.wait();
+            delete l->loop;
+            delete l;
+        }
+        sessionLoops.clear();
+
         gstEventLoop->stop();      // stop glib event loop
         gstEventLoopThread.quit(); // stop qt even loop in its thread
         gstEventLoopThread.wait(); // wait till everything is eventually stopped
@@ -87,6 +125,50 @@ GstProvider::~GstProvider()
     }
 }
 
+// the least loaded loop. a new one is only started once every running
+//   loop has a session on it
+GstMainLoop *GstProvider::acquireSessionLoop()
+{
+    QMutexLocker locker(&sessionLoopsMutex);
+
+    SessionLoop *least = nullptr;
+    for (SessionLoop *l : std::as_const(sessionLoops)) {
+        if (!least || l->sessions < least->sessions)
+            least = l;
+    }
+
+    if ((!least || least->sessions > 0) && sessionLoops.count() < maxSessionLoops) {
+        auto l = new SessionLoop;
+        l->thread.setObjectName(QString("GstSessionLoop%1").arg(sessionLoops.count()));
+        l->loop = new GstMainLoop(resourcePath);
+        if (startLoop(&l->thread, l->loop)) {
+            sessionLoops += l;
+            least = l;
+        } else {
+            delete l->loop;
+            delete l;
+        }
+    }
+
+    // sessions share the main loop if there are no others
+    if (!least)
+        return gstEventLoop;
+
+    ++least->sessions;
+    return least->loop;
+}
+
+void GstProvider::releaseSessionLoop(GstMainLoop *loop)
+{
+    QMutexLocker locker(&sessionLoopsMutex);
+    for (SessionLoop *l : std::as_const(sessionLoops)) {
+        if (l->loop == loop) {
+            --l->sessions;
+            break;
+        }
+    }
+}
+
 QObject *GstProvider::qobject() { return this; }
 
 bool GstProvider::isInitialized() const { return gstEventLoop && gstEventLoop->isInitialized(); }
@@ -106,7 +188,13 @@ QString GstProvider::creditText() const
 
 FeaturesContext *GstProvider::createFeatures() { return new GstFeaturesContext(gstEventLoop, deviceMonitor); }
 
-RtpSessionContext *GstProvider::createRtpSession() { return new GstRtpSessionContext(gstEventLoop, deviceMonitor); }
+RtpSessionContext *GstProvider::createRtpSession()
+{
+    GstMainLoop *loop    = acquireSessionLoop();
+    auto         session = new GstRtpSessionContext(loop, deviceMonitor);
+    connect(session, &QObject::destroyed, this, [this, loop]() { releaseSessionLoop(loop); });
+    return session;
+}
 
 AudioRecorderContext *GstProvider::createAudioRecorder() { return new GstAudioRecorderContext(gstEventLoop); }
 
@@ -21,6 +21,8 @@
 
 #include "psimediaprovider.h"
 
+#include <QList>
+#include <QMutex>
 #include <QPointer>
 #include <QThread>
 #include <QVariantMap>
@@ -48,6 +50,25 @@ public:
     FeaturesContext      *createFeatures() override;
     RtpSessionContext    *createRtpSession() override;
     AudioRecorderContext *createAudioRecorder() override;
+
+private:
+    // sessions are spread over loops of their own, so that one session
+    //   blocking in gstreamer doesn't hold up the others. device
+    //   monitoring, features and recording stay on gstEventLoop
+    class SessionLoop {
+    public:
+        QThread      thread;
+        GstMainLoop *loop     = nullptr;
+        int          sessions = 0;
+    };
+
+    QString              resourcePath;
+    int                  maxSessionLoops = 0;
+    QMutex               sessionLoopsMutex;
+    QList<SessionLoop *> sessionLoops;
+
+    GstMainLoop *acquireSessionLoop();
+    void         releaseSessionLoop(GstMainLoop *loop);
 };
 
 }
@@ -33,12 +33,20 @@
 //   sense in keeping ancient data around.  we just drop and move on.
 #define QUEUE_PACKET_MAX 25
 
-// don't wake the main thread more often than this, for performance reasons
-#define WAKE_PACKET_MIN 40
+// however big a frame batch is, the queue doesn't grow past this. it's a
+//   few hundred ms of 720p video
+#define QUEUE_PACKET_GROW_MAX 512
 
 namespace PsiMedia {
 
-GstRtpChannel::GstRtpChannel() { }
+GstRtpChannel::GstRtpChannel() : wakeTimer(this)
+{
+    ring.resize(QUEUE_PACKET_MAX);
+    ring_times.resize(QUEUE_PACKET_MAX);
+    ring_capacity = QUEUE_PACKET_MAX;
+    wakeTimer.setSingleShot(true);
+    connect(&wakeTimer, &QTimer::timeout, this, &GstRtpChannel::processIn);
+}
 
 QObject *GstRtpChannel::qobject() { return this; }
 
@@ -48,9 +56,63 @@ void GstRtpChannel::setEnabled(bool b)
     enabled = b;
 }
 
-int GstRtpChannel::packetsAvailable() const { return in.count(); }
+int GstRtpChannel::packetsAvailable() const
+{
+    QMutexLocker locker(&m);
+    return ring_count;
+}
 
-PRtpPacket GstRtpChannel::read() { return in.takeFirst(); }
+PRtpPacket GstRtpChannel::read()
+{
+    QMutexLocker locker(&m);
+    PRtpPacket   rtp;
+    if (ring_count > 0) {
+        stats_.queueLatency.add(PRtpPacket::currentTime() - ring_times[ring_head]);
+
+        // swap rather than copy, so the slot lets go of the payload
+        std::swap(rtp, ring[ring_head]);
+        ring_head = (ring_head + 1) % ring.count();
+        --ring_count;
+        shrinkIfDrained();
+    }
+    return rtp;
+}
+
+QVector<PRtpPacket> GstRtpChannel::readAll()
+{
+    QMutexLocker        locker(&m);
+    QVector<PRtpPacket> ret;
+    qint64              now = PRtpPacket::currentTime();
+    ret.reserve(ring_count);
+    for (; ring_count > 0; --ring_count) {
+        stats_.queueLatency.add(now - ring_times[ring_head]);
+        ret += PRtpPacket();
+        std::swap(ret.last(), ring[ring_head]);
+        ring_head = (ring_head + 1) % ring.count();
+    }
+    shrinkIfDrained();
+    return ret;
+}
+
+void GstRtpChannel::setQueueLimits(int capacity, int wakePackets, int wakeIntervalMs)
+{
+    QMutexLocker locker(&m);
+    if (capacity < 1)
+        capacity = QUEUE_PACKET_MAX;
+
+    ring_capacity = capacity;
+    if (capacity != ring.count())
+        resize(capacity);
+
+    wake_packets  = qBound(1, wakePackets, capacity);
+    wake_interval = qMax(0, wakeIntervalMs);
+}
+
+PRtpChannelStats GstRtpChannel::stats() const
+{
+    QMutexLocker locker(&m);
+    return stats_;
+}
 
 void GstRtpChannel::receiver_push_packet_for_write(const PRtpPacket &rtp)
 {
@@ -58,52 +120,179 @@ void GstRtpChannel::receiver_push_packet_for_write(const PRtpPacket &rtp)
         session->push_packet_for_write(this, rtp);
 }
 
-void GstRtpChannel::write(const PRtpPacket &rtp)
+void GstRtpChannel::receiver_push_packets_for_write(const QVector<PRtpPacket> &packets)
 {
-    m.lock();
-    if (!enabled)
-        return;
-    m.unlock();
+    if (session)
+        session->push_packets_for_write(this, packets);
+}
 
-    receiver_push_packet_for_write(rtp);
-    ++written_pending;
+void GstRtpChannel::packets_written(int count)
+{
+    bool wake = (written_pending == 0);
+    written_pending += count;
 
     // only queue one call per eventloop pass
-    if (written_pending == 1)
+    if (wake)
         QMetaObject::invokeMethod(this, "processOut", Qt::QueuedConnection);
 }
 
-void GstRtpChannel::push_packet_for_read(const PRtpPacket &rtp)
+void GstRtpChannel::write(const PRtpPacket &rtp)
 {
-    QMutexLocker locker(&m);
-    if (!enabled)
+    {
+        QMutexLocker locker(&m);
+        if (!enabled)
+            return;
+    }
+
+    receiver_push_packet_for_write(rtp);
+    packets_written(1);
+}
+
+void GstRtpChannel::writeBatch(const QVector<PRtpPacket> &packets)
+{
+    if (packets.isEmpty())
         return;
 
+    {
+        QMutexLocker locker(&m);
+        if (!enabled)
+            return;
+    }
+
+    receiver_push_packets_for_write(packets);
+    packets_written(int(packets.count()));
+}
+
+// m must be locked
+void GstRtpChannel::resize(int capacity)
+{
+    // keep the newest packets that still fit
+    QVector<PRtpPacket> newRing(capacity);
+    QVector<qint64>     newTimes(capacity);
+    int                 skip = qMax(0, ring_count - capacity);
+    for (int n = skip; n < ring_count; ++n) {
+        std::swap(newRing[n - skip], ring[(ring_head + n) % ring.count()]);
+        newTimes[n - skip] = ring_times[(ring_head + n) % ring.count()];
+    }
+    stats_.packetsDropped += quint64(skip);
+    ring       = std::move(newRing);
+    ring_times = std::move(newTimes);
+    ring_head  = 0;
+    ring_count = qMin(ring_count, capacity);
+}
+
+// m must be locked
+void GstRtpChannel::shrinkIfDrained()
+{
+    // once a grown ring is down to half of its usual size, nothing more
+    //   is held than would fit in that
+    if (ring.count() > ring_capacity && ring_count <= ring_capacity / 2)
+        resize(ring_capacity);
+}
+
+// m must be locked
+void GstRtpChannel::enqueue(const PRtpPacket &rtp, qint64 now)
+{
+    int  capacity = ring.count();
+    bool wasFull  = ring_count == capacity;
+
     // if the queue is full, bump off the oldest to make room
-    if (pending_in.count() >= QUEUE_PACKET_MAX)
-        pending_in.removeFirst();
+    if (wasFull) {
+        ring_head = (ring_head + 1) % capacity;
+        --ring_count;
+        ++stats_.packetsDropped;
+    }
 
-    pending_in += rtp;
+    int at         = (ring_head + ring_count) % capacity;
+    ring[at]       = rtp;
+    ring_times[at] = now;
+    ++ring_count;
+    if (rtp.timestamp >= 0)
+        stats_.pipelineLatency.add(now - rtp.timestamp);
+    ++stats_.packetsQueued;
+    // counted once per time it fills up, not for every packet bumped off
+    //   while it stays full. those are in packetsDropped
+    if (!wasFull && ring_count == capacity)
+        ++stats_.overflows;
+    stats_.maxQueued = qMax(stats_.maxQueued, ring_count);
+}
 
-    // TODO: use WAKE_PACKET_MIN and wake_time ?
+// m must be locked
+void GstRtpChannel::scheduleWake()
+{
+    if (wake_pending)
+        return;
 
-    if (!wake_pending) {
+    if (wake_interval == 0 || ring_count >= wake_packets) {
         wake_pending = true;
         QMetaObject::invokeMethod(this, "processIn", Qt::QueuedConnection);
+    } else if (!wake_timer_armed) {
+        // the timer must be started from our own thread
+        wake_timer_armed = true;
+        QMetaObject::invokeMethod(this, "armWakeTimer", Qt::QueuedConnection);
     }
 }
 
+void GstRtpChannel::push_packet_for_read(const PRtpPacket &rtp)
+{
+    QMutexLocker locker(&m);
+    if (!enabled)
+        return;
+
+    enqueue(rtp, PRtpPacket::currentTime());
+    scheduleWake();
+}
+
+// one lock and at most one wakeup for the whole batch
+void GstRtpChannel::push_packets_for_read(const QVector<PRtpPacket> &packets)
+{
+    QMutexLocker locker(&m);
+    if (!enabled)
+        return;
+
+    // a batch is a whole video frame, and bumping off its first packets
+    //   would cost the receiver the frame (or a keyframe, and everything
+    //   up to the next one). grow to fit it instead, within reason, but
+    //   count it, since it means the queue limits are too low for the
+    //   stream
+    int count = int(packets.count());
+    int limit = qMax(ring_capacity, QUEUE_PACKET_GROW_MAX);
+    if (count > ring.count() && ring.count() < limit) {
+        resize(qMin(ring_count + count, limit));
+        ++stats_.batchOverflows;
+    }
+
+    qint64 now = PRtpPacket::currentTime();
+    for (const PRtpPacket &rtp : packets)
+        enqueue(rtp, now);
+    scheduleWake();
+}
+
+void GstRtpChannel::armWakeTimer()
+{
+    int interval;
+    {
+        QMutexLocker locker(&m);
+        if (!wake_timer_armed)
+            return;
+        interval = wake_interval;
+    }
+
+    if (!wakeTimer.isActive())
+        wakeTimer.start(interval);
+}
+
 void GstRtpChannel::processIn()
 {
-    int oldcount = in.count();
+    wakeTimer.stop();
 
     m.lock();
-    wake_pending = false;
-    in += pending_in;
-    pending_in.clear();
+    wake_pending     = false;
+    wake_timer_armed = false;
+    int count        = ring_count;
     m.unlock();
 
-    if (in.count() > oldcount)
+    if (count > 0)
         emit readyRead();
 }
 
@@ -25,6 +25,8 @@
 
 #include <QMutex>
 #include <QObject>
+#include <QTimer>
+#include <QVector>
 
 namespace PsiMedia {
 
@@ -36,13 +38,29 @@ class GstRtpChannel : public QObject, public RtpChannelContext {
 
 public:
     bool                  enabled = false;
-    QMutex                m;
+    mutable QMutex        m;
     GstRtpSessionContext *session = nullptr;
-    QList<PRtpPacket>     in;
 
-    // QTime wake_time;
-    bool              wake_pending = false;
-    QList<PRtpPacket> pending_in;
+    // fixed-size ring of packets waiting to be read. slots are reused, so
+    //   queueing a packet never allocates. a batch bigger than the ring
+    //   grows it for a while, up to QUEUE_PACKET_GROW_MAX, and it goes back
+    //   to ring_capacity, as set by the queue limits, once the reader has
+    //   drained it
+    QVector<PRtpPacket> ring;
+    QVector<qint64>     ring_times; // when each slot was queued
+    int                 ring_head     = 0;
+    int                 ring_count    = 0;
+    int                 ring_capacity = 0;
+
+    // wake the reader once this many packets are queued, or once the
+    //   oldest queued packet is this old, whichever comes first
+    int    wake_packets     = 1;
+    int    wake_interval    = 0;
+    bool   wake_pending     = false;
+    bool   wake_timer_armed = false;
+    QTimer wakeTimer;
+
+    PRtpChannelStats stats_;
 
     int written_pending = 0;
 
@@ -58,8 +76,17 @@ public:
 
     virtual void write(const PRtpPacket &rtp);
 
-    // session calls this, which may be in another thread
+    virtual QVector<PRtpPacket> readAll();
+
+    virtual void writeBatch(const QVector<PRtpPacket> &packets);
+
+    virtual void setQueueLimits(int capacity, int wakePackets, int wakeIntervalMs);
+
+    virtual PRtpChannelStats stats() const;
+
+    // session calls these, which may be in another thread
     void push_packet_for_read(const PRtpPacket &rtp);
+    void push_packets_for_read(const QVector<PRtpPacket> &packets);
 
 Q_SIGNALS:
     void readyRead();
@@ -70,8 +97,16 @@ private Q_SLOTS:
 
     void processOut();
 
+    void armWakeTimer();
+
 private:
     void receiver_push_packet_for_write(const PRtpPacket &rtp);
+    void receiver_push_packets_for_write(const QVector<PRtpPacket> &packets);
+    void packets_written(int count);
+    void resize(int capacity);
+    void shrinkIfDrained();
+    void enqueue(const PRtpPacket &rtp, qint64 now);
+    void scheduleWake();
 };
 } // namespace PsiMedia
 
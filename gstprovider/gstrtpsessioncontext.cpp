@@ -6,6 +6,8 @@
 #endif
 #include "devices.h"
 
+#include <QTimer>
+
 namespace PsiMedia {
 
 GstRtpSessionContext::GstRtpSessionContext(GstMainLoop *_gstLoop, DeviceMonitor *deviceMonitor, QObject *parent) :
@@ -29,7 +31,17 @@ GstRtpSessionContext::GstRtpSessionContext(GstMainLoop *_gstLoop, DeviceMonitor
     connect(&recorder, SIGNAL(stopped()), SLOT(recorder_stopped()));
 }
 
-GstRtpSessionContext::~GstRtpSessionContext() { cleanup(); }
+GstRtpSessionContext::~GstRtpSessionContext()
+{
+    // both lists change as we go
+    const auto targets = forwardTargets;
+    for (GstRtpSessionContext *target : targets)
+        removeForwardTarget(target);
+    const auto sources = forwardSources;
+    for (GstRtpSessionContext *source : sources)
+        source->removeForwardTarget(this);
+    cleanup();
+}
 
 QObject *GstRtpSessionContext::qobject() { return this; }
 
@@ -40,7 +52,8 @@ void GstRtpSessionContext::cleanup()
     if (previewWidget)
         previewWidget->show_frame(QImage());
 
-    codecs = RwControlConfigCodecs();
+    codecs    = RwControlConfigCodecs();
+    lastStats = PRtpSessionStats();
 
     isStarted      = false;
     isStopping     = false;
@@ -53,6 +66,17 @@ void GstRtpSessionContext::cleanup()
     delete control;
     control = nullptr;
     write_mutex.unlock();
+
+    // outside of write_mutex, since the i/o threads may be waiting on it
+    forward_mutex.lock();
+    RtpUdpTransport *oldAudioTransport = audioTransport;
+    RtpUdpTransport *oldVideoTransport = videoTransport;
+    audioTransport                     = nullptr;
+    videoTransport                     = nullptr;
+    forward_mutex.unlock();
+
+    delete oldAudioTransport;
+    delete oldVideoTransport;
 }
 
 void GstRtpSessionContext::setAudioOutputDevice(const QString &deviceId)
@@ -169,6 +193,10 @@ void GstRtpSessionContext::setLocalVideoPreferences(const QList<PVideoParams> &p
 
 void GstRtpSessionContext::setMaximumSendingBitrate(int kbps) { codecs.maximumSendingBitrate = kbps; }
 
+void GstRtpSessionContext::setRealtimeVideoEncoding(bool enabled) { codecs.realtimeVideoEncoding = enabled; }
+
+void GstRtpSessionContext::setOpusOptions(const POpusOptions &options) { codecs.opusOptions = options; }
+
 void GstRtpSessionContext::setRemoteAudioPreferences(const QList<PPayloadInfo> &info)
 {
     codecs.useRemoteAudioPayloadInfo = true;
@@ -179,12 +207,23 @@ void GstRtpSessionContext::setRemoteVideoPreferences(const QList<PPayloadInfo> &
 {
     codecs.useRemoteVideoPayloadInfo = true;
     codecs.remoteVideoPayloadInfo    = info;
+
+    // the remote's payload types are what arrives here to be forwarded
+    forwarder.setVideoPayloadInfo(info);
 }
 
 void GstRtpSessionContext::start()
 {
     Q_ASSERT(!control && !isStarted);
 
+    if (!startTransports()) {
+        lastStatus           = RwControlStatus();
+        lastStatus.error     = true;
+        lastStatus.errorCode = RtpSessionContext::ErrorSystem;
+        QTimer::singleShot(0, this, [this]() { control_statusReady(lastStatus); });
+        return;
+    }
+
     write_mutex.lock();
 
     control = new RwControlLocal(gstLoop, hardwareDeviceMonitor, this);
@@ -193,11 +232,14 @@ void GstRtpSessionContext::start()
     connect(control, SIGNAL(outputFrame(const QImage &)), SLOT(control_outputFrame(const QImage &)));
     connect(control, SIGNAL(audioOutputIntensityChanged(int)), SLOT(control_audioOutputIntensityChanged(int)));
     connect(control, SIGNAL(audioInputIntensityChanged(int)), SLOT(control_audioInputIntensityChanged(int)));
+    connect(control, SIGNAL(statisticsReady(const PRtpSessionStats &)),
+            SLOT(control_statisticsReady(const PRtpSessionStats &)));
 
-    control->app            = this;
-    control->cb_rtpAudioOut = cb_control_rtpAudioOut;
-    control->cb_rtpVideoOut = cb_control_rtpVideoOut;
-    control->cb_recordData  = cb_control_recordData;
+    control->app                 = this;
+    control->cb_rtpAudioOut      = cb_control_rtpAudioOut;
+    control->cb_rtpVideoOut      = cb_control_rtpVideoOut;
+    control->cb_rtpVideoOutBatch = cb_control_rtpVideoOutBatch;
+    control->cb_recordData       = cb_control_recordData;
 
     allow_writes = true;
     write_mutex.unlock();
@@ -242,6 +284,18 @@ void GstRtpSessionContext::pauseVideo()
     control->setTransmit(transmit);
 }
 
+void GstRtpSessionContext::hold()
+{
+    Q_ASSERT(control);
+    control->setHold(true);
+}
+
+void GstRtpSessionContext::resume()
+{
+    Q_ASSERT(control);
+    control->setHold(false);
+}
+
 void GstRtpSessionContext::stop()
 {
     Q_ASSERT(control && !isStopping);
@@ -289,12 +343,93 @@ void GstRtpSessionContext::setInputVolume(int level)
         control->updateDevices(devices);
 }
 
+void GstRtpSessionContext::setAudioConference(bool enabled) { devices.audioConference = enabled; }
+
+void GstRtpSessionContext::setParticipantVolume(quint32 ssrc, int level)
+{
+    devices.participantVolumes[ssrc] = level;
+    if (control)
+        control->updateDevices(devices);
+}
+
+void GstRtpSessionContext::setParticipantMuted(quint32 ssrc, bool muted)
+{
+    if (muted)
+        devices.mutedParticipants += ssrc;
+    else
+        devices.mutedParticipants -= ssrc;
+    if (control)
+        control->updateDevices(devices);
+}
+
+void GstRtpSessionContext::addForwardTarget(RtpSessionContext *target)
+{
+    auto t = qobject_cast<GstRtpSessionContext *>(target->qobject());
+    if (!t || t == this || forwardTargets.contains(t))
+        return;
+
+    forwardTargets += t;
+    t->forwardSources += this;
+    forwarder.addTarget(t, cb_forwarder_packets);
+}
+
+void GstRtpSessionContext::removeForwardTarget(RtpSessionContext *target)
+{
+    auto t = qobject_cast<GstRtpSessionContext *>(target->qobject());
+    if (!t || !forwardTargets.removeOne(t))
+        return;
+
+    t->forwardSources.removeOne(this);
+    forwarder.removeTarget(t);
+}
+
 RtpSessionContext::Error GstRtpSessionContext::errorCode() const { return static_cast<Error>(lastStatus.errorCode); }
 
 RtpChannelContext *GstRtpSessionContext::audioRtpChannel() { return &audioRtp; }
 
 RtpChannelContext *GstRtpSessionContext::videoRtpChannel() { return &videoRtp; }
 
+void GstRtpSessionContext::setAudioUdpTransport(const PUdpTransport &transport) { audioTransportParams = transport; }
+
+void GstRtpSessionContext::setVideoUdpTransport(const PUdpTransport &transport) { videoTransportParams = transport; }
+
+PRtpSessionStats GstRtpSessionContext::statistics() const { return lastStats; }
+
+bool GstRtpSessionContext::startTransports()
+{
+    // both are started before either is handed out, so a failure of the
+    //   second can't leave the first running. they're stopped outside of
+    //   forward_mutex, as in cleanup()
+    RtpUdpTransport *audio = nullptr;
+    RtpUdpTransport *video = nullptr;
+    bool             ok    = true;
+
+    if (!audioTransportParams.isNull()) {
+        audio                  = new RtpUdpTransport;
+        audio->app             = this;
+        audio->cb_packetsReady = cb_audioTransport_packetsReady;
+        ok                     = audio->start(audioTransportParams);
+    }
+
+    if (ok && !videoTransportParams.isNull()) {
+        video                  = new RtpUdpTransport;
+        video->app             = this;
+        video->cb_packetsReady = cb_videoTransport_packetsReady;
+        ok                     = video->start(videoTransportParams);
+    }
+
+    if (!ok) {
+        delete audio;
+        delete video;
+        return false;
+    }
+
+    QMutexLocker locker(&forward_mutex);
+    audioTransport = audio;
+    videoTransport = video;
+    return true;
+}
+
 void GstRtpSessionContext::dumpPipeline(std::function<void(const QStringList &)> callback)
 {
     if (control)
@@ -305,6 +440,9 @@ void GstRtpSessionContext::dumpPipeline(std::function<void(const QStringList &)>
 
 void GstRtpSessionContext::push_packet_for_write(GstRtpChannel *from, const PRtpPacket &rtp)
 {
+    if (forwarder.hasTargets())
+        forwarder.forward(from == &audioRtp ? RtpForwarder::Audio : RtpForwarder::Video, QVector<PRtpPacket>() << rtp);
+
     QMutexLocker locker(&write_mutex);
     if (!allow_writes || !control)
         return;
@@ -315,6 +453,21 @@ void GstRtpSessionContext::push_packet_for_write(GstRtpChannel *from, const PRtp
         control->rtpVideoIn(rtp);
 }
 
+void GstRtpSessionContext::push_packets_for_write(GstRtpChannel *from, const QVector<PRtpPacket> &packets)
+{
+    if (forwarder.hasTargets())
+        forwarder.forward(from == &audioRtp ? RtpForwarder::Audio : RtpForwarder::Video, packets);
+
+    QMutexLocker locker(&write_mutex);
+    if (!allow_writes || !control)
+        return;
+
+    if (from == &audioRtp)
+        control->rtpAudioIn(packets);
+    else if (from == &videoRtp)
+        control->rtpVideoIn(packets);
+}
+
 void GstRtpSessionContext::control_statusReady(const RwControlStatus &status)
 {
     lastStatus = status;
@@ -377,6 +530,12 @@ void GstRtpSessionContext::control_audioInputIntensityChanged(int intensity)
     emit audioInputIntensityChanged(intensity);
 }
 
+void GstRtpSessionContext::control_statisticsReady(const PRtpSessionStats &stats)
+{
+    lastStats = stats;
+    emit statisticsUpdated();
+}
+
 void GstRtpSessionContext::recorder_stopped() { emit stoppedRecording(); }
 
 void GstRtpSessionContext::cb_control_rtpAudioOut(const PRtpPacket &packet, void *app)
@@ -389,15 +548,70 @@ void GstRtpSessionContext::cb_control_rtpVideoOut(const PRtpPacket &packet, void
     static_cast<GstRtpSessionContext *>(app)->control_rtpVideoOut(packet);
 }
 
+void GstRtpSessionContext::cb_control_rtpVideoOutBatch(const QVector<PRtpPacket> &packets, void *app)
+{
+    static_cast<GstRtpSessionContext *>(app)->control_rtpVideoOutBatch(packets);
+}
+
 void GstRtpSessionContext::cb_control_recordData(const QByteArray &packet, void *app)
 {
     static_cast<GstRtpSessionContext *>(app)->control_recordData(packet);
 }
 
-void GstRtpSessionContext::control_rtpAudioOut(const PRtpPacket &packet) { audioRtp.push_packet_for_read(packet); }
+void GstRtpSessionContext::cb_audioTransport_packetsReady(const QVector<PRtpPacket> &packets, void *app)
+{
+    auto self = static_cast<GstRtpSessionContext *>(app);
+    self->push_packets_for_write(&self->audioRtp, packets);
+}
+
+void GstRtpSessionContext::cb_videoTransport_packetsReady(const QVector<PRtpPacket> &packets, void *app)
+{
+    auto self = static_cast<GstRtpSessionContext *>(app);
+    self->push_packets_for_write(&self->videoRtp, packets);
+}
+
+void GstRtpSessionContext::cb_forwarder_packets(RtpForwarder::Media media, const QVector<PRtpPacket> &packets,
+                                                void *app)
+{
+    static_cast<GstRtpSessionContext *>(app)->forwarded_packets(media, packets);
+}
 
-void GstRtpSessionContext::control_rtpVideoOut(const PRtpPacket &packet) { videoRtp.push_packet_for_read(packet); }
+void GstRtpSessionContext::control_rtpAudioOut(const PRtpPacket &packet)
+{
+    if (audioTransport)
+        audioTransport->write(packet);
+    else
+        audioRtp.push_packet_for_read(packet);
+}
+
+void GstRtpSessionContext::control_rtpVideoOut(const PRtpPacket &packet)
+{
+    if (videoTransport)
+        videoTransport->write(packet);
+    else
+        videoRtp.push_packet_for_read(packet);
+}
+
+void GstRtpSessionContext::control_rtpVideoOutBatch(const QVector<PRtpPacket> &packets)
+{
+    if (videoTransport)
+        videoTransport->write(packets);
+    else
+        videoRtp.push_packets_for_read(packets);
+}
 
 void GstRtpSessionContext::control_recordData(const QByteArray &packet) { recorder.push_data_for_read(packet); }
 
+void GstRtpSessionContext::forwarded_packets(RtpForwarder::Media media, const QVector<PRtpPacket> &packets)
+{
+    QMutexLocker     locker(&forward_mutex);
+    RtpUdpTransport *transport = media == RtpForwarder::Audio ? audioTransport : videoTransport;
+    if (transport)
+        transport->write(packets);
+    else if (media == RtpForwarder::Audio)
+        audioRtp.push_packets_for_read(packets);
+    else
+        videoRtp.push_packets_for_read(packets);
+}
+
 } // namespace PsiMedia
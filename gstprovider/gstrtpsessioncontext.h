@@ -25,6 +25,8 @@
 
 #include "gstrecorder.h"
 #include "gstrtpchannel.h"
+#include "rtpforwarder.h"
+#include "rtpudptransport.h"
 #include "rwcontrol.h"
 
 namespace PsiMedia {
@@ -48,6 +50,7 @@ public:
     RwControlConfigCodecs  codecs;
     RwControlTransmit      transmit;
     RwControlStatus        lastStatus;
+    PRtpSessionStats       lastStats;
     DeviceMonitor         *hardwareDeviceMonitor;
     bool                   isStarted;
     bool                   isStopping;
@@ -65,6 +68,20 @@ public:
     QMutex        write_mutex;
     bool          allow_writes;
 
+    // when set, packets bypass the channels and go straight to the network
+    PUdpTransport    audioTransportParams;
+    PUdpTransport    videoTransportParams;
+    RtpUdpTransport *audioTransport = nullptr;
+    RtpUdpTransport *videoTransport = nullptr;
+
+    // sessions we forward to, and sessions forwarding to us. the
+    //   transports above are only touched under forward_mutex by the
+    //   forwarders of other sessions
+    RtpForwarder                  forwarder;
+    QList<GstRtpSessionContext *> forwardTargets;
+    QList<GstRtpSessionContext *> forwardSources;
+    QMutex                        forward_mutex;
+
     explicit GstRtpSessionContext(GstMainLoop *_gstLoop, DeviceMonitor *deviceMonitor, QObject *parent = nullptr);
 
     ~GstRtpSessionContext() override;
@@ -89,6 +106,8 @@ public:
     void                setLocalAudioPreferences(const QList<PAudioParams> &params) override;
     void                setLocalVideoPreferences(const QList<PVideoParams> &params) override;
     void                setMaximumSendingBitrate(int kbps) override;
+    void                setRealtimeVideoEncoding(bool enabled) override;
+    void                setOpusOptions(const POpusOptions &options) override;
     void                setRemoteAudioPreferences(const QList<PPayloadInfo> &info) override;
     void                setRemoteVideoPreferences(const QList<PPayloadInfo> &info) override;
     void                start() override;
@@ -98,6 +117,8 @@ public:
     void                pauseAudio() override;
     void                pauseVideo() override;
     void                stop() override;
+    void                hold() override;
+    void                resume() override;
     QList<PPayloadInfo> localAudioPayloadInfo() const override;
     QList<PPayloadInfo> localVideoPayloadInfo() const override;
     QList<PPayloadInfo> remoteAudioPayloadInfo() const override;
@@ -110,13 +131,22 @@ public:
     void                setOutputVolume(int level) override;
     int                 inputVolume() const override;
     void                setInputVolume(int level) override;
+    void                setAudioConference(bool enabled) override;
+    void                setParticipantVolume(quint32 ssrc, int level) override;
+    void                setParticipantMuted(quint32 ssrc, bool muted) override;
+    void                addForwardTarget(RtpSessionContext *target) override;
+    void                removeForwardTarget(RtpSessionContext *target) override;
     Error               errorCode() const override;
     RtpChannelContext  *audioRtpChannel() override;
     RtpChannelContext  *videoRtpChannel() override;
+    void                setAudioUdpTransport(const PUdpTransport &transport) override;
+    void                setVideoUdpTransport(const PUdpTransport &transport) override;
+    PRtpSessionStats    statistics() const override;
     void                dumpPipeline(std::function<void(const QStringList &)> callback) override;
 
     // channel calls this, which may be in another thread
     void push_packet_for_write(GstRtpChannel *from, const PRtpPacket &rtp);
+    void push_packets_for_write(GstRtpChannel *from, const QVector<PRtpPacket> &packets);
 
 signals:
     void started();
@@ -127,6 +157,7 @@ signals:
     void stopped();
     void finished();
     void error();
+    void statisticsUpdated();
 
 private slots:
     void control_statusReady(const RwControlStatus &status);
@@ -134,12 +165,19 @@ private slots:
     void control_outputFrame(const QImage &img);
     void control_audioOutputIntensityChanged(int intensity);
     void control_audioInputIntensityChanged(int intensity);
+    void control_statisticsReady(const PRtpSessionStats &stats);
     void recorder_stopped();
 
 private:
     static void cb_control_rtpAudioOut(const PRtpPacket &packet, void *app);
     static void cb_control_rtpVideoOut(const PRtpPacket &packet, void *app);
+    static void cb_control_rtpVideoOutBatch(const QVector<PRtpPacket> &packets, void *app);
     static void cb_control_recordData(const QByteArray &packet, void *app);
+    static void cb_audioTransport_packetsReady(const QVector<PRtpPacket> &packets, void *app);
+    static void cb_videoTransport_packetsReady(const QVector<PRtpPacket> &packets, void *app);
+    static void cb_forwarder_packets(RtpForwarder::Media media, const QVector<PRtpPacket> &packets, void *app);
+
+    bool startTransports();
 
     // note: this is executed from a different thread
     void control_rtpAudioOut(const PRtpPacket &packet);
@@ -147,8 +185,14 @@ private:
     // note: this is executed from a different thread
     void control_rtpVideoOut(const PRtpPacket &packet);
 
+    // note: this is executed from a different thread
+    void control_rtpVideoOutBatch(const QVector<PRtpPacket> &packets);
+
     // note: this is executed from a different thread
     void control_recordData(const QByteArray &packet);
+
+    // note: this is executed from a different thread
+    void forwarded_packets(RtpForwarder::Media media, const QVector<PRtpPacket> &packets);
 };
 
 } // namespace PsiMedia
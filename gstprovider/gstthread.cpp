@@ -20,6 +20,8 @@
 
 #include "gstthread.h"
 
+#include "codecs.h"
+
 #include <QCoreApplication>
 #include <QDir>
 #include <QIcon>
@@ -192,7 +194,8 @@ public:
                                 "vp8dec",       "rtpopuspay",    "rtpopusdepay",    "rtpvp8pay",  "rtpvp8depay",
                                 "filesrc",      "decodebin",     "jpegdec",         "oggmux",     "oggdemux",
                                 "audioconvert", "audioresample", "volume",          "level",      "videoconvert",
-                                "videorate",    "videoscale",    "rtpjitterbuffer", "audiomixer", "appsink" };
+                                "videorate",    "videoscale",    "rtpbin",          "audiomixer", "appsink",
+                                "valve" };
 #ifndef Q_OS_WIN
         reqelem << "webrtcechoprobe";
 #endif
@@ -221,6 +224,7 @@ public:
             g_object_unref(G_OBJECT(e));
         }
 
+        codecs_probe();
         success = true;
     }
 
@@ -20,104 +20,55 @@
 
 #include "modes.h"
 
-// #include <gst/gst.h>
+#include "codecs.h"
 
-namespace PsiMedia {
-
-// FIXME: any better way besides hardcoding?
-
-/*static bool have_element(const QString &name)
-{
-    GstElement *e = gst_element_factory_make(name.toLatin1().data(), nullptr);
-    if(!e)
-        return false;
-
-    g_object_unref(G_OBJECT(e));
-    return true;
-}
+#include <QStringList>
 
-static bool have_codec(const QString &enc, const QString &dec, const QString &pay, const QString &depay)
-{
-    if(have_element(enc) && have_element(dec) && have_element(pay) && have_element(depay))
-        return true;
-    else
-        return false;
-}
-
-static bool have_pcmu()
-{
-    return have_codec("mulawenc", "mulawdec", "rtppcmupay", "rtppcmudepay");
-}
-
-static bool have_h263p()
-{
-    return have_codec("ffenc_h263p", "ffdec_h263", "rtph263ppay", "rtph263pdepay");
-}*/
+namespace PsiMedia {
 
-// opus, vp8 are guaranteed to exist
+// the modes of the codec table, for the codecs that are installed
 
 QList<PAudioParams> modes_supportedAudio()
 {
     QList<PAudioParams> list;
-    /*if(have_pcmu())
-    {
-        PAudioParams p;
-        p.codec = "pcmu";
-        p.sampleRate = 8000;
-        p.sampleSize = 16;
-        p.channels = 1;
-        list += p;
-    }*/
-    {
-        PAudioParams p;
-        p.codec      = "opus";
-        p.sampleRate = 8000;
-        p.sampleSize = 16;
-        p.channels   = 1;
-        list += p;
-    }
-    {
-        PAudioParams p;
-        p.codec      = "opus";
-        p.sampleRate = 16000;
-        p.sampleSize = 16;
-        p.channels   = 1;
-        list += p;
+    for (const CodecDesc *c : codecs_available(CodecDesc::Audio)) {
+        const QStringList modes = QString::fromLatin1(c->modes).split(' ');
+        for (const QString &m : modes) {
+            // rate/size/channels
+            const QStringList parts = m.split('/');
+            if (parts.count() != 3)
+                continue;
+
+            PAudioParams p;
+            p.codec      = QString::fromLatin1(c->name);
+            p.sampleRate = parts[0].toInt();
+            p.sampleSize = parts[1].toInt();
+            p.channels   = parts[2].toInt();
+            list += p;
+        }
     }
-    /*{
-        PAudioParams p;
-        p.codec = "opus";
-        p.sampleRate = 32000;
-        p.sampleSize = 16;
-        p.channels = 1;
-        list += p;
-    }
-    {
-        PAudioParams p;
-        p.codec = "vorbis";
-        p.sampleRate = 44100;
-        p.sampleSize = 32;
-        p.channels = 2;
-        list += p;
-    }*/
     return list;
 }
 
 QList<PVideoParams> modes_supportedVideo()
 {
     QList<PVideoParams> list;
-
-    {
-        PVideoParams p;
-        p.codec = "vp8";
-        p.size  = QSize(640, 480);
-        p.fps   = 30;
-        list += p;
-
-        p.size = { 1280, 720 };
-        list += p;
+    for (const CodecDesc *c : codecs_available(CodecDesc::Video)) {
+        const QStringList modes = QString::fromLatin1(c->modes).split(' ');
+        for (const QString &m : modes) {
+            // WxH@fps
+            const QStringList parts = m.split('@');
+            const QStringList size  = parts[0].split('x');
+            if (parts.count() != 2 || size.count() != 2)
+                continue;
+
+            PVideoParams p;
+            p.codec = QString::fromLatin1(c->name);
+            p.size  = QSize(size[0].toInt(), size[1].toInt());
+            p.fps   = parts[1].toInt();
+            list += p;
+        }
     }
-
     return list;
 }
 
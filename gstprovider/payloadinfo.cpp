@@ -231,6 +231,7 @@ PPayloadInfo structureToPayloadInfo(GstStructure *structure, QString *media)
     //   dynamic parameters
     QStringList whitelist;
     whitelist << "sampling" << "width" << "height" << "delivery-method" << "configuration";
+    whitelist << "profile-level-id" << "packetization-mode" << "sprop-parameter-sets";
 
     QList<PPayloadInfo::Parameter> list;
 
@@ -23,10 +23,13 @@
 #include "devices.h"
 
 #include <QList>
+#include <QMutex>
 #include <QSet>
+#include <QWaitCondition>
 #include <gst/gst.h>
 
 #include <algorithm>
+#include <atomic>
 #include <ranges>
 
 // FIXME: this file is heavily commented out and a mess, mainly because
@@ -166,6 +169,43 @@ static GstElement *make_webrtcdsp_filter()
     return capsfilter;
 }
 
+gulong pipeline_blockPadWhenIdle(GstPad *pad)
+{
+    class Blocker {
+    public:
+        QMutex         m;
+        QWaitCondition w;
+        bool           blocked = false;
+
+        static GstPadProbeReturn cb(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+        {
+            Q_UNUSED(pad);
+            Q_UNUSED(info);
+            auto         self = static_cast<Blocker *>(user_data);
+            QMutexLocker locker(&self->m);
+            self->blocked = true;
+            self->w.wakeAll();
+            return GST_PAD_PROBE_OK;
+        }
+
+        static void destroy(gpointer user_data) { delete static_cast<Blocker *>(user_data); }
+    };
+
+    // the callback may run right away in this thread, so don't hold the
+    //   lock while adding the probe
+    auto   blocker = new Blocker;
+    gulong id      = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_IDLE, &Blocker::cb, blocker, &Blocker::destroy);
+
+    QMutexLocker locker(&blocker->m);
+    if (!blocker->blocked)
+        blocker->w.wait(&blocker->m, 1000);
+#ifdef PIPELINE_DEBUG
+    if (!blocker->blocked)
+        qDebug("timed out waiting for pad to block");
+#endif
+    return id;
+}
+
 //----------------------------------------------------------------------------
 // PipelineContext
 //----------------------------------------------------------------------------
@@ -203,12 +243,16 @@ public:
     GstElement *audioconvert  = nullptr;
     GstElement *audioresample = nullptr;
     GstElement *webrtcprobe   = nullptr;
+    GstElement *aoutdev       = nullptr;
+
+    // device switching
+    qint64          switchStarted = 0; // PRtpPacket::currentTime()
+    std::atomic_int switchGlitch { -1 };
 
 private:
-    GstElement *makeDeviceBin(const PipelineDeviceOptions &options, DeviceMonitor *deviceMonitor)
+    GstElement *makeDeviceElement(const QString &deviceId, QSize *captureSize)
     {
-        QSize       captureSize;
-        GstElement *deviceElement = devices_makeElement(id, type, &captureSize);
+        GstElement *deviceElement = devices_makeElement(deviceId, type, captureSize);
         if (!deviceElement)
             return nullptr;
 
@@ -225,6 +269,45 @@ private:
             }
         }
 
+        return deviceElement;
+    }
+
+    // a bin around a launch line that gives raw video
+    GstElement *makeLaunchBin(const QString &launchLine)
+    {
+        GstElement *e = gst_parse_launch(launchLine.toLatin1().data(), nullptr);
+        if (!e)
+            return nullptr;
+
+        GstPad *pad = gst_element_get_static_pad(e, "src");
+        if (!pad) {
+            gst_object_unref(e);
+            return nullptr;
+        }
+
+        GstElement *bin = gst_bin_new(nullptr);
+        gst_bin_add(GST_BIN(bin), e);
+        gst_element_add_pad(bin, gst_ghost_pad_new("src", pad));
+        gst_object_unref(GST_OBJECT(pad));
+        return bin;
+    }
+
+    GstElement *makeDeviceBin(const PipelineDeviceOptions &options, DeviceMonitor *deviceMonitor)
+    {
+        // a video input the monitor doesn't know, like an unplugged camera,
+        //   fails. unless it is explicitly a launch line, e.g. videotestsrc
+        //   when running headless
+        if (type == PDevice::VideoIn && !deviceMonitor->device(id)) {
+            if (!id.startsWith(QLatin1String(PIPELINE_LAUNCH_PREFIX)))
+                return nullptr;
+            return makeLaunchBin(id.mid(int(sizeof(PIPELINE_LAUNCH_PREFIX)) - 1));
+        }
+
+        QSize       captureSize;
+        GstElement *deviceElement = makeDeviceElement(id, &captureSize);
+        if (!deviceElement)
+            return nullptr;
+
         GstElement *bin = gst_bin_new(nullptr); // FIXME not necessary for audio?
 
         if (type == PDevice::AudioIn) {
@@ -258,10 +341,6 @@ private:
         } else if (type == PDevice::VideoIn) {
 
             auto device = deviceMonitor->device(id);
-            if (!device) {
-                gst_object_unref(deviceElement);
-                return nullptr;
-            }
 
 #ifdef Q_OS_MAC
             // FIXME: hardcode resolution because filter_for_desired_size
@@ -291,7 +370,7 @@ path2::caps="video/x-raw" \
             if (captureSize.isValid())
                 capsfilter = filter_for_capture_size(captureSize);
             else if (options.videoSize.isValid())
-                capsfilter = filter_for_desired_size(device, options.videoSize);
+                capsfilter = filter_for_desired_size(&*device, options.videoSize);
 
             gst_bin_add(GST_BIN(bin), deviceElement);
 
@@ -378,6 +457,7 @@ path2::caps="video/x-raw" \
                 gst_bin_add(GST_BIN(bin), webrtcprobe);
             }
             gst_bin_add(GST_BIN(bin), deviceElement);
+            aoutdev = deviceElement;
 
             if (webrtcprobe)
                 gst_element_link_many(audioconvert, audioresample, capsfilter, webrtcprobe, deviceElement, nullptr);
@@ -433,10 +513,15 @@ public:
             return;
 
         if (type == PDevice::AudioIn || type == PDevice::VideoIn) {
+            // the pipeline may still be running if just this device is
+            //   being dropped from a live session
+            gst_element_set_state(device_bin, GST_STATE_NULL);
             gst_bin_remove(GST_BIN(pipeline), device_bin);
 
-            if (tee)
+            if (tee) {
+                gst_element_set_state(tee, GST_STATE_NULL);
                 gst_bin_remove(GST_BIN(pipeline), tee);
+            }
         } else // AudioOut
         {
             gst_element_set_state(device_bin, GST_STATE_NULL);
@@ -482,6 +567,7 @@ public:
             deactivate(context);
 
             GstElement *queue = context->element;
+            gst_element_set_state(queue, GST_STATE_NULL);
             gst_bin_remove(GST_BIN(pipeline), queue);
         }
 
@@ -644,6 +730,145 @@ NULL
     }
 
     QString echoProbeName() const { return webrtcEchoProbeName; }
+
+    static GstPadProbeReturn cb_switch_data(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+    {
+        Q_UNUSED(pad);
+        Q_UNUSED(info);
+        auto self = static_cast<PipelineDevice *>(user_data);
+        self->switchGlitch.store(int((PRtpPacket::currentTime() - self->switchStarted) / 1000));
+        return GST_PAD_PROBE_REMOVE;
+    }
+
+    // audio devices are swapped inside device_bin, so the dsp and echo
+    //   probe around them keep running. video swaps the whole bin in
+    //   front of the tee, as its decoding depends on the device
+    bool switchTo(const QString &newId, PipelineDeviceContextPrivate *context, DeviceMonitor *deviceMonitor,
+                  bool *clockLost)
+    {
+        GstElement *old = type == PDevice::AudioIn ? aindev : (type == PDevice::AudioOut ? aoutdev : device_bin);
+        if (!old)
+            return false;
+
+#ifdef PIPELINE_DEBUG
+        qDebug("Switching %s:[%s] to [%s]", type_to_str(type), qPrintable(id), qPrintable(newId));
+#endif
+
+        GstElement *replacement = nullptr;
+        if (type == PDevice::VideoIn) {
+            QString oldId = id;
+            id            = newId;
+            replacement   = makeDeviceBin(context->opts, deviceMonitor);
+            if (!replacement)
+                id = oldId;
+        } else {
+            QSize captureSize;
+            replacement = makeDeviceElement(newId, &captureSize);
+        }
+        if (!replacement)
+            return false;
+
+        GstElement *parent = type == PDevice::VideoIn ? pipeline : device_bin;
+
+        // the pad the data crosses between the device and the rest. for
+        //   sinks that is the one feeding it
+        GstPad *pad;
+        if (type == PDevice::AudioOut) {
+            GstPad *sinkpad = gst_element_get_static_pad(old, "sink");
+            pad             = gst_pad_get_peer(sinkpad);
+            gst_object_unref(sinkpad);
+        } else
+            pad = gst_element_get_static_pad(old, "src");
+
+        // a device without a direct link (ghosted straight out of
+        //   device_bin) is retargeted instead
+        GstPad *ghost = nullptr;
+        if (type == PDevice::AudioIn) {
+            GstPad *binPad = gst_element_get_static_pad(device_bin, "src");
+            GstPad *target = gst_ghost_pad_get_target(GST_GHOST_PAD(binPad));
+            if (target == pad)
+                ghost = binPad;
+            else
+                gst_object_unref(binPad);
+            if (target)
+                gst_object_unref(target);
+        }
+
+        if (clockLost) {
+            GstClock *provided = gst_element_provide_clock(old);
+            GstClock *current  = gst_element_get_clock(pipeline);
+            *clockLost         = provided && provided == current;
+            if (provided)
+                gst_object_unref(provided);
+            if (current)
+                gst_object_unref(current);
+        }
+
+        switchStarted = PRtpPacket::currentTime();
+        switchGlitch.store(-1);
+        gulong probeId = pad ? pipeline_blockPadWhenIdle(pad) : 0;
+
+        GstPad *peer = nullptr;
+        if (type == PDevice::AudioOut) {
+            GstPad *sinkpad = gst_element_get_static_pad(old, "sink");
+            if (pad)
+                gst_pad_unlink(pad, sinkpad);
+            gst_object_unref(sinkpad);
+        } else if (!ghost && pad) {
+            peer = gst_pad_get_peer(pad);
+            if (peer)
+                gst_pad_unlink(pad, peer);
+        }
+
+        // this also lets go of a src pad blocked above
+        gst_element_set_state(old, GST_STATE_NULL);
+        gst_bin_remove(GST_BIN(parent), old);
+
+        gst_bin_add(GST_BIN(parent), replacement);
+
+        GstPad *measurePad = nullptr;
+        if (type == PDevice::AudioIn) {
+            aindev = replacement;
+            gst_element_set_name(replacement, "aindev");
+
+            GstPad *srcpad = gst_element_get_static_pad(replacement, "src");
+            if (ghost)
+                gst_ghost_pad_set_target(GST_GHOST_PAD(ghost), srcpad);
+            else if (peer)
+                gst_pad_link(srcpad, peer);
+            gst_object_unref(srcpad);
+            measurePad = gst_element_get_static_pad(device_bin, "src");
+        } else if (type == PDevice::AudioOut) {
+            aoutdev = replacement;
+
+            GstPad *sinkpad = gst_element_get_static_pad(replacement, "sink");
+            if (pad)
+                gst_pad_link(pad, sinkpad);
+            measurePad = sinkpad;
+        } else {
+            device_bin = replacement;
+            gst_element_link(device_bin, tee);
+            measurePad = gst_element_get_static_pad(tee, "sink");
+        }
+
+        gst_pad_add_probe(measurePad, GstPadProbeType(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                          &cb_switch_data, this, nullptr);
+        gst_object_unref(measurePad);
+
+        gst_element_sync_state_with_parent(replacement);
+
+        if (pad) {
+            gst_pad_remove_probe(pad, probeId);
+            gst_object_unref(pad);
+        }
+        if (peer)
+            gst_object_unref(peer);
+        if (ghost)
+            gst_object_unref(ghost);
+
+        id = newId;
+        return true;
+    }
 };
 
 class PipelineContext::Private {
@@ -773,4 +998,17 @@ void PipelineDeviceContext::setOptions(const PipelineDeviceOptions &opts)
 
 PipelineDeviceOptions PipelineDeviceContext::options() const { return d->opts; }
 
+QString PipelineDeviceContext::id() const { return d->device->id; }
+
+bool PipelineDeviceContext::switchDevice(const QString &id, DeviceMonitor *deviceMonitor, bool *clockLost)
+{
+    if (clockLost)
+        *clockLost = false;
+    if (id == d->device->id)
+        return true;
+    return d->device->switchTo(id, d, deviceMonitor, clockLost);
+}
+
+int PipelineDeviceContext::lastSwitchGlitch() const { return d->device->switchGlitch.load(); }
+
 }
@@ -24,6 +24,7 @@
 #include "psimediaprovider.h"
 #include <QString>
 #include <gst/gstelement.h>
+#include <gst/gstpad.h>
 
 namespace PsiMedia {
 
@@ -31,6 +32,15 @@ class PipelineDeviceContext;
 class PipelineDeviceContextPrivate;
 class DeviceMonitor;
 
+// a video input id starting with this is not looked up among the devices,
+//   the rest of it is a launch line giving raw video. meant for tests
+#define PIPELINE_LAUNCH_PREFIX "launch:"
+
+// installs a blocking probe on pad that takes hold once nothing is being
+//   pushed through it, and waits up to a second for that. the pad stays
+//   blocked until the probe is removed or the pad is deactivated
+gulong pipeline_blockPadWhenIdle(GstPad *pad);
+
 class PipelineContext {
 public:
     PipelineContext();
@@ -101,6 +111,21 @@ public:
     void                  setOptions(const PipelineDeviceOptions &opts);
     PipelineDeviceOptions options() const;
 
+    QString id() const;
+
+    // moves a running device over to another one of the same type without
+    //   stopping the pipeline. whatever is linked to element() stays as it
+    //   is, and so do echo cancellation and its probe. returns false, with
+    //   the old device still in place, if the new one can't be created.
+    //   clockLost is set if the pipeline was running on a clock provided
+    //   by the old device, in which case the caller has to pick a new one
+    bool switchDevice(const QString &id, DeviceMonitor *deviceMonitor, bool *clockLost = nullptr);
+
+    // ms from the old device being cut off until the first buffer of the
+    //   new one, for the last switchDevice(). -1 if there was no switch or
+    //   nothing has arrived yet
+    int lastSwitchGlitch() const;
+
 private:
     PipelineDeviceContext();
 
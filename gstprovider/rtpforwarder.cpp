@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "rtpforwarder.h"
+
+#include "rtppacketpool.h"
+
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cstring>
+
+// packets kept since the last keyframe. a longer group of pictures is
+//   dropped, and late joiners wait for the next keyframe instead of
+//   getting a burst that large
+#define GOP_PACKET_MAX 1024
+
+namespace PsiMedia {
+
+namespace {
+
+    quint16 readU16(const uchar *p) { return quint16((p[0] << 8) | p[1]); }
+
+    quint32 readU32(const uchar *p) { return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (p[2] << 8) | p[3]; }
+
+    void writeU16(uchar *p, quint16 val)
+    {
+        p[0] = uchar(val >> 8);
+        p[1] = uchar(val);
+    }
+
+    void writeU32(uchar *p, quint32 val)
+    {
+        p[0] = uchar(val >> 24);
+        p[1] = uchar(val >> 16);
+        p[2] = uchar(val >> 8);
+        p[3] = uchar(val);
+    }
+
+    // offset of the rtp payload, or -1 if this isn't an rtp packet
+    int payloadOffset(const uchar *p, int size)
+    {
+        if (size < 12 || (p[0] >> 6) != 2)
+            return -1;
+
+        int at = 12 + (p[0] & 0x0f) * 4;
+        if (p[0] & 0x10) {
+            if (at + 4 > size)
+                return -1;
+            at += 4 + readU16(p + at + 2) * 4;
+        }
+        return at <= size ? at : -1;
+    }
+
+    // rfc 7741: offset of the vp8 payload header if this packet begins a
+    //   frame (start of partition 0), otherwise -1
+    int vp8FrameStart(const uchar *p, int size)
+    {
+        if (size < 1 || !(p[0] & 0x10) || (p[0] & 0x07))
+            return -1;
+
+        int at = 1;
+        if (p[0] & 0x80) {
+            if (size < 2)
+                return -1;
+            uchar x = p[1];
+            at      = 2;
+            if (x & 0x80) {
+                if (at >= size)
+                    return -1;
+                at += (p[at] & 0x80) ? 2 : 1;
+            }
+            if (x & 0x40)
+                ++at;
+            if (x & 0x30)
+                ++at;
+        }
+        return at < size ? at : -1;
+    }
+
+    // the frame header follows the descriptor, with P clear for a keyframe
+    bool vp8Keyframe(const uchar *p, int size)
+    {
+        int hdr = vp8FrameStart(p, size);
+        return hdr >= 0 && !(p[hdr] & 0x01);
+    }
+
+    bool h264KeyNal(uchar nal)
+    {
+        int type = nal & 0x1f;
+        return type == 5 || type == 7; // idr slice or sequence parameter set
+    }
+
+    // rfc 6184: a key nal unit on its own, in a stap-a or starting a fu-a
+    bool h264Keyframe(const uchar *p, int size)
+    {
+        if (size < 1)
+            return false;
+
+        int type = p[0] & 0x1f;
+        if (type == 24) {
+            for (int at = 1; at + 2 < size; at += 2 + readU16(p + at)) {
+                if (h264KeyNal(p[at + 2]))
+                    return true;
+            }
+            return false;
+        }
+        if (type == 28)
+            return size >= 2 && (p[1] & 0x80) && h264KeyNal(p[1]);
+        return h264KeyNal(p[0]);
+    }
+
+    // rfc 9628: the start of a frame (B) without inter prediction (P), in
+    //   the base spatial layer if there are layer indices
+    bool vp9Keyframe(const uchar *p, int size)
+    {
+        if (size < 1 || (p[0] & 0x48) != 0x08)
+            return false;
+        if (!(p[0] & 0x20))
+            return true;
+
+        int at = 1;
+        if (p[0] & 0x80) {
+            if (at >= size)
+                return false;
+            at += (p[at] & 0x80) ? 2 : 1;
+        }
+        return at < size && ((p[at] >> 1) & 0x07) == 0;
+    }
+
+    // av1 rtp: N marks the first packet of a coded video sequence, which
+    //   opens with a keyframe
+    bool av1Keyframe(const uchar *p, int size) { return size >= 1 && (p[0] & 0x08) && !(p[0] & 0x80); }
+
+    class KeyframeCodec {
+    public:
+        const char *name; // as in the payload info
+        bool (*keyframe)(const uchar *p, int size);
+    };
+
+    const KeyframeCodec keyframeCodecs[] = {
+        { "VP8", vp8Keyframe },
+        { "H264", h264Keyframe },
+        { "VP9", vp9Keyframe },
+        { "AV1", av1Keyframe },
+    };
+
+    quint16 packetSeq(const PRtpPacket &packet)
+    {
+        return readU16(reinterpret_cast<const uchar *>(packet.rawValue.constData()) + 2);
+    }
+
+    quint32 packetTimestamp(const PRtpPacket &packet)
+    {
+        return readU32(reinterpret_cast<const uchar *>(packet.rawValue.constData()) + 4);
+    }
+
+    // a copy of the packet with its ssrc and sequence number replaced.
+    //   the payload is not touched
+    PRtpPacket rewrite(const PRtpPacket &in, quint32 ssrc, quint16 seq)
+    {
+        char      *data = nullptr;
+        int        size = int(in.rawValue.size());
+        PRtpPacket out  = RtpPacketPool::instance()->allocate(size, &data, in.portOffset);
+        memcpy(data, in.rawValue.constData(), size_t(size));
+        writeU16(reinterpret_cast<uchar *>(data) + 2, seq);
+        writeU32(reinterpret_cast<uchar *>(data) + 8, ssrc);
+        out.timestamp = in.timestamp;
+        return out;
+    }
+
+}
+
+class RtpForwarder::Target {
+public:
+    enum State {
+        WaitKeyframe, // nothing sent yet, waiting for something decodable
+        Live
+    };
+
+    class Stream {
+    public:
+        quint32 ssrc      = 0;
+        quint32 srcSsrc   = 0;
+        quint16 nextSeq   = 0;
+        quint16 seqOffset = 0;
+        bool    anchored  = false;
+        State   state     = Live;
+    };
+
+    void               *app  = nullptr;
+    SinkFunc            sink = nullptr;
+    Stream              streams[2];
+    QVector<PRtpPacket> out;
+
+    PRtpPacket next(Stream &s, const PRtpPacket &packet, quint16 seq)
+    {
+        quint16 outSeq = quint16(seq + s.seqOffset);
+        // late or reordered packets keep their place in the sequence
+        if (qint16(outSeq - s.nextSeq) >= 0)
+            s.nextSeq = quint16(outSeq + 1);
+        return rewrite(packet, s.ssrc, outSeq);
+    }
+};
+
+RtpForwarder::RtpForwarder() { }
+
+RtpForwarder::~RtpForwarder() { qDeleteAll(targets_); }
+
+void RtpForwarder::addTarget(void *app, SinkFunc sink)
+{
+    QMutexLocker locker(&mutex_);
+    for (Target *t : std::as_const(targets_)) {
+        if (t->app == app)
+            return;
+    }
+
+    auto t  = new Target;
+    t->app  = app;
+    t->sink = sink;
+    for (int n = 0; n < 2; ++n) {
+        Target::Stream &s = t->streams[n];
+        s.ssrc            = QRandomGenerator::global()->generate();
+        s.nextSeq         = quint16(QRandomGenerator::global()->generate());
+        s.state           = n == Video ? Target::WaitKeyframe : Target::Live;
+    }
+    targets_ += t;
+    targetCount_.store(int(targets_.count()), std::memory_order_release);
+}
+
+void RtpForwarder::removeTarget(void *app)
+{
+    QMutexLocker locker(&mutex_);
+    for (int n = 0; n < targets_.count(); ++n) {
+        if (targets_[n]->app == app) {
+            delete targets_.takeAt(n);
+            break;
+        }
+    }
+    targetCount_.store(int(targets_.count()), std::memory_order_release);
+}
+
+void RtpForwarder::setVideoPayloadInfo(const QList<PPayloadInfo> &info)
+{
+    QMutexLocker locker(&mutex_);
+    std::fill(std::begin(videoKeyframe_), std::end(videoKeyframe_), nullptr);
+    for (const PPayloadInfo &pi : info) {
+        if (pi.id < 0 || pi.id > 127)
+            continue;
+        for (const KeyframeCodec &c : keyframeCodecs) {
+            if (pi.name.compare(QLatin1String(c.name), Qt::CaseInsensitive) == 0)
+                videoKeyframe_[pi.id] = c.keyframe;
+        }
+    }
+
+    sources_[Video].gop.clear();
+}
+
+// mutex_ must be locked
+void RtpForwarder::updateGop(Source &src, const PRtpPacket &packet, bool keyframeStart)
+{
+    if (keyframeStart) {
+        src.gop.clear();
+        src.gop += packet;
+        return;
+    }
+
+    // nothing is kept until the next keyframe
+    if (src.gop.isEmpty())
+        return;
+
+    if (src.gop.count() >= GOP_PACKET_MAX) {
+        src.gop.clear();
+        return;
+    }
+    src.gop += packet;
+}
+
+void RtpForwarder::forward(Media media, const QVector<PRtpPacket> &packets)
+{
+    QMutexLocker locker(&mutex_);
+    if (targets_.isEmpty())
+        return;
+
+    Source &src = sources_[media];
+    for (const PRtpPacket &packet : packets) {
+        if (packet.portOffset != 0)
+            continue;
+
+        auto p    = reinterpret_cast<const uchar *>(packet.rawValue.constData());
+        int  size = int(packet.rawValue.size());
+        int  at   = payloadOffset(p, size);
+        if (at < 0)
+            continue;
+
+        quint16 seq  = readU16(p + 2);
+        quint32 ssrc = readU32(p + 8);
+
+        // a new source stream invalidates the kept pictures
+        bool newSource = !src.haveSsrc || ssrc != src.ssrc;
+        if (newSource) {
+            src.ssrc     = ssrc;
+            src.haveSsrc = true;
+            src.gop.clear();
+        }
+
+        // audio, and video we can't parse, is passed straight through:
+        //   every packet is as good a place as any for a target to start
+        KeyframeFunc keyframe = media == Video ? videoKeyframe_[p[1] & 0x7f] : nullptr;
+        if (keyframe) {
+            // h264 can carry keyframe data in several packets of a frame
+            //   (sps, then idr), the group starts with the first of them
+            bool keyframeStart = keyframe(p + at, size - at)
+                && (src.gop.isEmpty() || packetTimestamp(src.gop.first()) != readU32(p + 4));
+            updateGop(src, packet, keyframeStart);
+        }
+
+        for (Target *t : std::as_const(targets_)) {
+            Target::Stream &s = t->streams[media];
+
+            if (s.state == Target::WaitKeyframe) {
+                if (keyframe) {
+                    if (src.gop.isEmpty())
+                        continue;
+
+                    // catch up from the keyframe to this packet, which
+                    //   is the last one kept, then carry on live. every
+                    //   frame the target gets has its references
+                    s.seqOffset = quint16(s.nextSeq - packetSeq(src.gop.first()));
+                    s.srcSsrc   = ssrc;
+                    s.anchored  = true;
+                    s.state     = Target::Live;
+                    for (const PRtpPacket &kept : std::as_const(src.gop))
+                        t->out += t->next(s, kept, packetSeq(kept));
+                    continue;
+                }
+                s.state    = Target::Live;
+                s.anchored = false;
+            }
+
+            // continue our own sequence wherever the source's is
+            if (!s.anchored || s.srcSsrc != ssrc) {
+                s.seqOffset = quint16(s.nextSeq - seq);
+                s.srcSsrc   = ssrc;
+                s.anchored  = true;
+            }
+
+            t->out += t->next(s, packet, seq);
+        }
+    }
+
+    quint64 count = 0;
+    for (Target *t : std::as_const(targets_)) {
+        if (t->out.isEmpty())
+            continue;
+        count += quint64(t->out.count());
+        t->sink(media, t->out, t->app);
+        t->out.clear();
+    }
+    forwarded_.fetch_add(count, std::memory_order_relaxed);
+}
+
+} // namespace PsiMedia
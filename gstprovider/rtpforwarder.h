@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_RTPFORWARDER_H
+#define PSIMEDIA_RTPFORWARDER_H
+
+#include "psimediaprovider.h"
+
+#include <QList>
+#include <QMutex>
+#include <atomic>
+
+namespace PsiMedia {
+
+// fans the rtp of one session out to any number of targets without
+//   decoding it. every target sees a stream with its own ssrc and an
+//   unbroken sequence, even across source ssrc changes. for video every
+//   packet since the last keyframe is kept, so that a target joining late
+//   gets the whole group of pictures and can decode from the live packet
+//   on, rather than waiting for the next keyframe. that works for vp8,
+//   h264, vp9 and av1, anything else is forwarded as is. rtcp is not
+//   forwarded, the targets terminate their own.
+class RtpForwarder {
+public:
+    enum Media { Audio = 0, Video = 1 };
+
+    // called with everything one forward() produced for the target. must
+    //   not call back into the forwarder
+    typedef void (*SinkFunc)(Media media, const QVector<PRtpPacket> &packets, void *app);
+
+    RtpForwarder();
+    ~RtpForwarder();
+
+    RtpForwarder(const RtpForwarder &)            = delete;
+    RtpForwarder &operator=(const RtpForwarder &) = delete;
+
+    // targets are identified by app. once removeTarget() returns the sink
+    //   is not called for it again
+    void addTarget(void *app, SinkFunc sink);
+    void removeTarget(void *app);
+    bool hasTargets() const { return targetCount_.load(std::memory_order_acquire) > 0; }
+
+    // the payload types of the forwarded video, which decide how keyframes
+    //   are found. safe to call from any thread
+    void setVideoPayloadInfo(const QList<PPayloadInfo> &info);
+
+    // safe to call from any thread. packets with a portOffset of 1 (rtcp)
+    //   are ignored
+    void forward(Media media, const QVector<PRtpPacket> &packets);
+
+    quint64 packetsForwarded() const { return forwarded_.load(std::memory_order_relaxed); }
+
+private:
+    class Target;
+
+    // whether an rtp payload holds the start of a keyframe
+    typedef bool (*KeyframeFunc)(const uchar *p, int size);
+
+    class Source {
+    public:
+        quint32             ssrc     = 0;
+        bool                haveSsrc = false;
+        QVector<PRtpPacket> gop; // from the start of the last keyframe on
+    };
+
+    mutable QMutex       mutex_;
+    QList<Target *>      targets_;
+    Source               sources_[2];
+    KeyframeFunc         videoKeyframe_[128] {}; // by payload type, nullptr to pass through
+    std::atomic_int      targetCount_ { 0 };
+    std::atomic<quint64> forwarded_ { 0 };
+
+    void updateGop(Source &src, const PRtpPacket &packet, bool keyframeStart);
+};
+
+} // namespace PsiMedia
+
+#endif // PSIMEDIA_RTPFORWARDER_H
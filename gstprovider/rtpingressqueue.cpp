@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "rtpingressqueue.h"
+
+#include <QtMath>
+
+namespace PsiMedia {
+
+RtpIngressQueue::RtpIngressQueue(int capacity)
+{
+    quint32 size = qNextPowerOfTwo(quint32(qMax(capacity, 1) - 1));
+    ring_.resize(size, nullptr);
+    mask_ = size - 1;
+}
+
+RtpIngressQueue::~RtpIngressQueue() { clear(); }
+
+bool RtpIngressQueue::push(GstBuffer *buffer)
+{
+    quint32 tail = tail_.load(std::memory_order_relaxed);
+    quint32 head = head_.load(std::memory_order_acquire);
+
+    // full. on a live stream the consumer is late anyway, so rather than
+    //   blocking the network thread we lose the packet
+    if (tail - head > mask_) {
+        gst_buffer_unref(buffer);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    ring_[tail & mask_] = buffer;
+    tail_.store(tail + 1, std::memory_order_release);
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+    // only the first packet after a drain needs to wake the consumer
+    return !wakePending_.exchange(true, std::memory_order_acq_rel);
+}
+
+GstBufferList *RtpIngressQueue::takeAll()
+{
+    // clear the flag before looking at the tail, so that anything pushed
+    //   after this point is guaranteed to trigger another wakeup
+    wakePending_.store(false, std::memory_order_release);
+
+    quint32 head = head_.load(std::memory_order_relaxed);
+    quint32 tail = tail_.load(std::memory_order_acquire);
+    if (head == tail)
+        return nullptr;
+
+    GstBufferList *list = gst_buffer_list_new_sized(tail - head);
+    for (; head != tail; ++head) {
+        gst_buffer_list_add(list, ring_[head & mask_]);
+        ring_[head & mask_] = nullptr;
+    }
+    head_.store(head, std::memory_order_release);
+
+    return list;
+}
+
+void RtpIngressQueue::clear()
+{
+    GstBufferList *list = takeAll();
+    if (list)
+        gst_buffer_list_unref(list);
+}
+
+bool RtpIngressQueue::isEmpty() const
+{
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+}
+
+} // namespace PsiMedia
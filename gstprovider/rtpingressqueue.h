@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_RTPINGRESSQUEUE_H
+#define PSIMEDIA_RTPINGRESSQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <gst/gst.h>
+#include <vector>
+
+namespace PsiMedia {
+
+// bounded single-producer/single-consumer ring of inbound rtp buffers.
+//   the producer side is RtpWorker::rtpAudioIn/rtpVideoIn (callers are
+//   serialized by GstRtpSessionContext::write_mutex), the consumer side is
+//   the glib loop the worker runs in. neither side ever blocks: when the
+//   ring is full the newest packet is dropped and counted.
+class RtpIngressQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit RtpIngressQueue(int capacity);
+    ~RtpIngressQueue();
+
+    RtpIngressQueue(const RtpIngressQueue &)            = delete;
+    RtpIngressQueue &operator=(const RtpIngressQueue &) = delete;
+
+    // producer. takes ownership of the buffer. returns true if the
+    //   consumer should be woken up
+    bool push(GstBuffer *buffer);
+
+    // consumer. returns nullptr if there is nothing queued
+    GstBufferList *takeAll();
+    void           clear();
+    bool           isEmpty() const;
+
+    // counters, safe to read from any thread
+    quint64 enqueued() const { return enqueued_.load(std::memory_order_relaxed); }
+    quint64 dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<GstBuffer *> ring_;
+    quint32                  mask_;
+    std::atomic<quint32>     head_ { 0 }; // next slot to read, owned by the consumer
+    std::atomic<quint32>     tail_ { 0 }; // next slot to write, owned by the producer
+    std::atomic_bool         wakePending_ { false };
+    std::atomic<quint64>     enqueued_ { 0 };
+    std::atomic<quint64>     dropped_ { 0 };
+};
+
+} // namespace PsiMedia
+
+#endif // PSIMEDIA_RTPINGRESSQUEUE_H
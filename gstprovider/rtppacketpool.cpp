@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "rtppacketpool.h"
+
+#include <cstring>
+#include <new>
+
+// blocks kept on each free list and arrays in the payload ring, unless
+//   overridden by PSI_RTP_POOL_SIZE
+#define POOL_FREE_MAX 1024
+
+// room for the shared_ptr control block that allocate_shared puts in
+//   front of the mapping
+#define POOL_BLOCK_OVERHEAD 64
+
+namespace PsiMedia {
+
+RtpSlab::RtpSlab(size_t blockSize, int maxFree) : blockSize_(blockSize), maxFree_(maxFree)
+{
+    free_.reserve(size_t(maxFree_));
+}
+
+RtpSlab::~RtpSlab()
+{
+    for (void *block : free_)
+        ::operator delete(block);
+}
+
+void *RtpSlab::allocate(size_t size)
+{
+    if (size <= blockSize_) {
+        QMutexLocker locker(&mutex_);
+        if (!free_.empty()) {
+            void *block = free_.back();
+            free_.pop_back();
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(qMax(size, blockSize_));
+}
+
+void RtpSlab::release(void *block, size_t size)
+{
+    if (size <= blockSize_) {
+        QMutexLocker locker(&mutex_);
+        // never grows past the reserved size, so this doesn't allocate
+        if (int(free_.size()) < maxFree_) {
+            free_.push_back(block);
+            return;
+        }
+    }
+
+    ::operator delete(block);
+}
+
+// how many slots to look at for an unshared array before giving up on
+//   the ring and going to the heap
+#define RING_PROBES 4
+
+RtpArrayRing::RtpArrayRing(int arraySize, int slots) : arraySize_(arraySize), slots_(size_t(slots)) { }
+
+QByteArray RtpArrayRing::take(int size, char **data)
+{
+    QMutexLocker locker(&mutex_);
+    if (!slots_.empty()) {
+        QByteArray *slot = nullptr;
+        for (int n = 0; n < RING_PROBES; ++n) {
+            slot  = &slots_[next_];
+            next_ = (next_ + 1) % slots_.size();
+
+            // the ring's reference is the only one left, so no packet can
+            //   see the bytes change. resizing within the reserved space
+            //   leaves the memory where it is
+            if (!slot->isNull() && slot->isDetached()) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                slot->resize(size);
+                *data = slot->data();
+                return *slot;
+            }
+        }
+
+        // replace the last slot probed. whoever still shares the old array
+        //   keeps it alive until they are done with it
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        *slot = QByteArray();
+        slot->reserve(arraySize_);
+        slot->resize(size);
+        *data = slot->data();
+        return *slot;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    QByteArray bytes(size, Qt::Uninitialized);
+    *data = bytes.data();
+    return bytes;
+}
+
+namespace {
+
+    // a read mapping of an outgoing buffer, shared by the packets viewing it
+    class MappedBuffer {
+    public:
+        GstBuffer *buffer;
+        GstMapInfo info;
+        bool       mapped;
+
+        explicit MappedBuffer(GstBuffer *_buffer) : buffer(gst_buffer_ref(_buffer))
+        {
+            mapped = gst_buffer_map(buffer, &info, GST_MAP_READ);
+        }
+
+        ~MappedBuffer()
+        {
+            if (mapped)
+                gst_buffer_unmap(buffer, &info);
+            gst_buffer_unref(buffer);
+        }
+    };
+
+    // lets allocate_shared put the control block and the payload into a
+    //   single slab block
+    template <typename T> class SlabAllocator {
+    public:
+        using value_type = T;
+
+        RtpSlab *slab;
+
+        explicit SlabAllocator(RtpSlab *_slab) : slab(_slab) { }
+        template <typename U> SlabAllocator(const SlabAllocator<U> &other) : slab(other.slab) { }
+
+        T   *allocate(std::size_t n) { return static_cast<T *>(slab->allocate(n * sizeof(T))); }
+        void deallocate(T *p, std::size_t n) { slab->release(p, n * sizeof(T)); }
+
+        template <typename U> bool operator==(const SlabAllocator<U> &other) const { return slab == other.slab; }
+        template <typename U> bool operator!=(const SlabAllocator<U> &other) const { return slab != other.slab; }
+    };
+
+    int poolFreeMax()
+    {
+        bool ok  = false;
+        int  val = qEnvironmentVariableIntValue("PSI_RTP_POOL_SIZE", &ok);
+        return ok && val >= 0 ? val : POOL_FREE_MAX;
+    }
+
+    void releaseWrappedPacket(gpointer data) { RtpPacketPool::instance()->release(static_cast<PRtpPacket *>(data)); }
+
+}
+
+RtpPacketPool::RtpPacketPool() :
+    payloads(PayloadSize, poolFreeMax()), holders(sizeof(PRtpPacket), poolFreeMax()),
+    views(sizeof(MappedBuffer) + POOL_BLOCK_OVERHEAD, poolFreeMax())
+{
+}
+
+RtpPacketPool *RtpPacketPool::instance()
+{
+    // never destroyed, since packets may outlive static destruction
+    static auto pool = new RtpPacketPool;
+    return pool;
+}
+
+PRtpPacket RtpPacketPool::allocate(int size, char **data, int portOffset)
+{
+    PRtpPacket packet;
+    packet.portOffset = portOffset;
+
+    if (size > PayloadSize) {
+        oversized_.fetch_add(1, std::memory_order_relaxed);
+        packet.rawValue.resize(size);
+        *data = packet.rawValue.data();
+        return packet;
+    }
+
+    packet.rawValue = payloads.take(size, data);
+    return packet;
+}
+
+PRtpPacket RtpPacketPool::copy(const char *data, int size, int portOffset)
+{
+    char      *dest   = nullptr;
+    PRtpPacket packet = allocate(size, &dest, portOffset);
+    memcpy(dest, data, size_t(size));
+    return packet;
+}
+
+PRtpPacket *RtpPacketPool::retain(const PRtpPacket &packet)
+{
+    return new (holders.allocate(sizeof(PRtpPacket))) PRtpPacket(packet);
+}
+
+void RtpPacketPool::release(PRtpPacket *packet)
+{
+    packet->~PRtpPacket();
+    holders.release(packet, sizeof(PRtpPacket));
+}
+
+// the buffer holds a pooled shallow copy of the packet, so the shared data
+//   stays alive (and unmodified, since any writer detaches) until gstreamer
+//   releases the memory
+GstBuffer *RtpPacketPool::wrap(const PRtpPacket &packet)
+{
+    if (packet.rawValue.isEmpty())
+        return nullptr;
+
+    auto  ref  = retain(packet);
+    gsize size = gsize(ref->rawValue.size());
+    return gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, const_cast<char *>(ref->rawValue.constData()), size,
+                                       0, size, ref, releaseWrappedPacket);
+}
+
+PRtpPacket RtpPacketPool::fromBuffer(GstBuffer *buffer, bool view)
+{
+    if (view) {
+        auto mapped = std::allocate_shared<MappedBuffer>(SlabAllocator<MappedBuffer>(&views), buffer);
+        if (mapped->mapped) {
+            auto       data = reinterpret_cast<const char *>(mapped->info.data);
+            PRtpPacket packet;
+            packet.portOffset = 0;
+            packet.rawValue   = QByteArray::fromRawData(data, int(mapped->info.size));
+            packet.storage    = mapped;
+            return packet;
+        }
+    }
+
+    int   sz     = int(gst_buffer_get_size(buffer));
+    char *data   = nullptr;
+    auto  packet = allocate(sz, &data);
+    gst_buffer_extract(buffer, 0, data, gsize(sz));
+    return packet;
+}
+
+RtpPacketPool::Stats RtpPacketPool::stats() const
+{
+    Stats s;
+    s.hits   = payloads.hits() + holders.hits() + views.hits();
+    s.misses = payloads.misses() + holders.misses() + views.misses() + oversized_.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace PsiMedia
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_RTPPACKETPOOL_H
+#define PSIMEDIA_RTPPACKETPOOL_H
+
+#include "psimediaprovider.h"
+
+#include <QMutex>
+#include <atomic>
+#include <gst/gst.h>
+#include <vector>
+
+namespace PsiMedia {
+
+// a free list of equally sized blocks. the heap is only used when the list
+//   is empty or for requests larger than a block, and released blocks go
+//   back on the list up to maxFree. safe to use from any thread
+class RtpSlab {
+public:
+    RtpSlab(size_t blockSize, int maxFree);
+    ~RtpSlab();
+
+    RtpSlab(const RtpSlab &)            = delete;
+    RtpSlab &operator=(const RtpSlab &) = delete;
+
+    void *allocate(size_t size);
+    void  release(void *block, size_t size);
+
+    size_t  blockSize() const { return blockSize_; }
+    quint64 hits() const { return hits_.load(std::memory_order_relaxed); }
+    quint64 misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    size_t               blockSize_;
+    int                  maxFree_;
+    QMutex               mutex_;
+    std::vector<void *>  free_;
+    std::atomic<quint64> hits_ { 0 };
+    std::atomic<quint64> misses_ { 0 };
+};
+
+// a ring of payload arrays with PayloadSize bytes reserved. an array is
+//   handed out again once every packet sharing it is gone, which the ring
+//   sees from the array no longer being shared. packets hold ordinary
+//   arrays, so their bytes stay valid for as long as anyone holds a copy
+class RtpArrayRing {
+public:
+    RtpArrayRing(int arraySize, int slots);
+
+    RtpArrayRing(const RtpArrayRing &)            = delete;
+    RtpArrayRing &operator=(const RtpArrayRing &) = delete;
+
+    // an array of size bytes, size must not exceed arraySize. *data is
+    //   where to write them, obtained before the array was shared, and is
+    //   to be filled in before the array is handed on
+    QByteArray take(int size, char **data);
+
+    quint64 hits() const { return hits_.load(std::memory_order_relaxed); }
+    quint64 misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    int                     arraySize_;
+    QMutex                  mutex_;
+    std::vector<QByteArray> slots_;
+    size_t                  next_ = 0;
+    std::atomic<quint64>    hits_ { 0 };
+    std::atomic<quint64>    misses_ { 0 };
+};
+
+// packet memory shared by ingress, egress and the udp transport. payloads
+//   up to PayloadSize bytes live in pooled arrays, so once the pool is warm
+//   moving a packet through the provider doesn't touch the heap
+class RtpPacketPool {
+public:
+    enum { PayloadSize = 2048 };
+
+    class Stats {
+    public:
+        quint64 hits   = 0; // allocations served from the free lists
+        quint64 misses = 0; // allocations that went to the heap
+    };
+
+    static RtpPacketPool *instance();
+
+    // a packet with size bytes of uninitialized payload, to be filled in
+    //   through *data before the packet is shared
+    PRtpPacket allocate(int size, char **data, int portOffset = 0);
+    PRtpPacket copy(const char *data, int size, int portOffset = 0);
+
+    // a heap copy of the packet for passing through C callbacks, to be
+    //   given back with release()
+    PRtpPacket *retain(const PRtpPacket &packet);
+    void        release(PRtpPacket *packet);
+
+    // a gst buffer referencing the packet payload without copying it, or
+    //   nullptr if the packet is empty
+    GstBuffer *wrap(const PRtpPacket &packet);
+
+    // a packet with the payload of the buffer. with view set, the packet
+    //   references the mapped buffer instead of getting a copy, and its
+    //   bytes are only valid while PRtpPacket::storage is held
+    PRtpPacket fromBuffer(GstBuffer *buffer, bool view);
+
+    Stats stats() const;
+
+private:
+    RtpArrayRing         payloads;
+    RtpSlab              holders;
+    RtpSlab              views;
+    std::atomic<quint64> oversized_ { 0 };
+
+    RtpPacketPool();
+};
+
+} // namespace PsiMedia
+
+#endif // PSIMEDIA_RTPPACKETPOOL_H
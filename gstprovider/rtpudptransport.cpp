@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "rtpudptransport.h"
+
+#include "rtppacketpool.h"
+
+#include <QDebug>
+
+// packets moved per send/receive syscall
+#define UDP_BATCH_MAX 32
+
+// anything larger than this is truncated on receive
+#define UDP_PACKET_MAX 2048
+
+namespace PsiMedia {
+
+struct UdpWriteSource {
+    GSource          parent;
+    RtpUdpTransport *transport;
+};
+
+static GInetAddress *make_inet_address(const QString &str, GSocketFamily family)
+{
+    if (str.isEmpty())
+        return g_inet_address_new_any(family);
+    return g_inet_address_new_from_string(str.toLatin1().data());
+}
+
+RtpUdpTransport::RtpUdpTransport() = default;
+
+RtpUdpTransport::~RtpUdpTransport() { stop(); }
+
+bool RtpUdpTransport::start(const PUdpTransport &params)
+{
+    Q_ASSERT(!thread);
+
+    GInetAddress *remoteAddr = nullptr;
+    if (!params.remoteAddress.isEmpty()) {
+        remoteAddr = g_inet_address_new_from_string(params.remoteAddress.toLatin1().data());
+        if (!remoteAddr || params.remoteBasePort <= 0) {
+            qWarning("RtpUdpTransport: invalid remote address %s:%d", qPrintable(params.remoteAddress),
+                     params.remoteBasePort);
+            if (remoteAddr)
+                g_object_unref(remoteAddr);
+            return false;
+        }
+    }
+
+    // the local side follows the remote address family unless given explicitly
+    GSocketFamily family    = remoteAddr ? g_inet_address_get_family(remoteAddr) : G_SOCKET_FAMILY_IPV4;
+    GInetAddress *localAddr = make_inet_address(params.localAddress, family);
+    if (!localAddr) {
+        qWarning("RtpUdpTransport: invalid local address %s", qPrintable(params.localAddress));
+        if (remoteAddr)
+            g_object_unref(remoteAddr);
+        return false;
+    }
+    family = g_inet_address_get_family(localAddr);
+
+    bool ok = true;
+    for (int n = 0; n < 2 && ok; ++n) {
+        GError *err = nullptr;
+        sockets[n]  = g_socket_new(family, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &err);
+        if (sockets[n]) {
+            g_socket_set_blocking(sockets[n], FALSE);
+
+            int             port = params.localBasePort > 0 ? params.localBasePort + n : 0;
+            GSocketAddress *addr = g_inet_socket_address_new(localAddr, guint16(port));
+            if (!g_socket_bind(sockets[n], addr, FALSE, &err))
+                ok = false;
+            g_object_unref(addr);
+        } else
+            ok = false;
+
+        if (!ok) {
+            qWarning("RtpUdpTransport: %s", err ? err->message : "unable to create socket");
+            g_clear_error(&err);
+            break;
+        }
+
+        if (remoteAddr)
+            remote[n] = g_inet_socket_address_new(remoteAddr, guint16(params.remoteBasePort + n));
+    }
+
+    g_object_unref(localAddr);
+    if (remoteAddr)
+        g_object_unref(remoteAddr);
+
+    if (!ok) {
+        cleanup();
+        return false;
+    }
+
+    scratch.resize(UDP_BATCH_MAX * UDP_PACKET_MAX);
+
+    context = g_main_context_new();
+    loop    = g_main_loop_new(context, FALSE);
+
+    for (int n = 0; n < 2; ++n) {
+        readSources[n] = g_socket_create_source(sockets[n], G_IO_IN, nullptr);
+        g_source_set_callback(readSources[n], reinterpret_cast<GSourceFunc>(cb_socket_readable), this, nullptr);
+        g_source_attach(readSources[n], context);
+    }
+
+    // armed with a ready time of 0 whenever the outgoing queue becomes
+    //   non-empty, so a burst of writes costs a single wakeup
+    static GSourceFuncs writeFuncs = { nullptr, nullptr, cb_write_dispatch, nullptr, nullptr, nullptr };
+    writeSource                    = g_source_new(&writeFuncs, sizeof(UdpWriteSource));
+    reinterpret_cast<UdpWriteSource *>(writeSource)->transport = this;
+    g_source_attach(writeSource, context);
+
+    thread = g_thread_new("psimedia-udp", cb_thread, this);
+    return true;
+}
+
+void RtpUdpTransport::stop()
+{
+    if (thread) {
+        // quit from inside the loop, in case it hasn't started running yet
+        GSource *quit = g_idle_source_new();
+        g_source_set_callback(
+            quit,
+            [](gpointer data) -> gboolean {
+                g_main_loop_quit(static_cast<GMainLoop *>(data));
+                return G_SOURCE_REMOVE;
+            },
+            loop, nullptr);
+        g_source_attach(quit, context);
+        g_source_unref(quit);
+
+        g_thread_join(thread);
+        thread = nullptr;
+    }
+
+    cleanup();
+}
+
+void RtpUdpTransport::cleanup()
+{
+    out_mutex.lock();
+    if (writeSource) {
+        g_source_destroy(writeSource);
+        g_source_unref(writeSource);
+        writeSource = nullptr;
+    }
+    out.clear();
+    out_mutex.unlock();
+
+    for (int n = 0; n < 2; ++n) {
+        if (readSources[n]) {
+            g_source_destroy(readSources[n]);
+            g_source_unref(readSources[n]);
+            readSources[n] = nullptr;
+        }
+        if (sockets[n]) {
+            g_socket_close(sockets[n], nullptr);
+            g_object_unref(sockets[n]);
+            sockets[n] = nullptr;
+        }
+        if (remote[n]) {
+            g_object_unref(remote[n]);
+            remote[n] = nullptr;
+        }
+    }
+
+    if (loop) {
+        g_main_loop_unref(loop);
+        loop = nullptr;
+    }
+    if (context) {
+        g_main_context_unref(context);
+        context = nullptr;
+    }
+}
+
+void RtpUdpTransport::write(const PRtpPacket &packet)
+{
+    if (packet.portOffset < 0 || packet.portOffset > 1 || !remote[packet.portOffset]) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    QMutexLocker locker(&out_mutex);
+    if (!writeSource)
+        return;
+
+    out += packet;
+    if (out.count() == 1)
+        g_source_set_ready_time(writeSource, 0);
+}
+
+void RtpUdpTransport::write(const QVector<PRtpPacket> &packets)
+{
+    QMutexLocker locker(&out_mutex);
+    if (!writeSource)
+        return;
+
+    bool wasEmpty = out.isEmpty();
+    for (const PRtpPacket &packet : packets) {
+        if (packet.portOffset < 0 || packet.portOffset > 1 || !remote[packet.portOffset])
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        else
+            out += packet;
+    }
+    if (wasEmpty && !out.isEmpty())
+        g_source_set_ready_time(writeSource, 0);
+}
+
+void RtpUdpTransport::readPending(int offset)
+{
+    RtpPacketPool      *pool = RtpPacketPool::instance();
+    QVector<PRtpPacket> packets;
+    for (;;) {
+        GError *err   = nullptr;
+        int     count = 0;
+
+#if GLIB_CHECK_VERSION(2, 48, 0)
+        GInputVector  vectors[UDP_BATCH_MAX];
+        GInputMessage messages[UDP_BATCH_MAX];
+        for (int n = 0; n < UDP_BATCH_MAX; ++n) {
+            vectors[n]  = { scratch.data() + n * UDP_PACKET_MAX, UDP_PACKET_MAX };
+            messages[n] = { nullptr, &vectors[n], 1, 0, 0, nullptr, nullptr };
+        }
+
+        count = g_socket_receive_messages(sockets[offset], messages, UDP_BATCH_MAX, 0, nullptr, &err);
+        for (int n = 0; n < count; ++n)
+            packets += pool->copy(scratch.constData() + n * UDP_PACKET_MAX, int(messages[n].bytes_received), offset);
+#else
+        while (count < UDP_BATCH_MAX) {
+            char  *buf  = scratch.data() + count * UDP_PACKET_MAX;
+            gssize size = g_socket_receive(sockets[offset], buf, UDP_PACKET_MAX, nullptr, &err);
+            if (size < 0)
+                break;
+
+            packets += pool->copy(buf, int(size), offset);
+            ++count;
+        }
+        if (count > 0)
+            g_clear_error(&err);
+#endif
+
+        if (err) {
+            if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+                qWarning("RtpUdpTransport: receive failed: %s", err->message);
+            g_error_free(err);
+            break;
+        }
+
+        // a short batch means the socket is drained
+        if (count < UDP_BATCH_MAX)
+            break;
+    }
+
+    if (packets.isEmpty())
+        return;
+
+    // everything drained in one wakeup counts as arriving together
+    qint64 now = PRtpPacket::currentTime();
+    for (PRtpPacket &packet : packets)
+        packet.timestamp = now;
+
+    received_.fetch_add(quint64(packets.count()), std::memory_order_relaxed);
+    if (cb_packetsReady)
+        cb_packetsReady(packets, app);
+}
+
+void RtpUdpTransport::writePending()
+{
+    QVector<PRtpPacket> packets;
+    out_mutex.lock();
+    packets.swap(out);
+    out_mutex.unlock();
+
+    // packets go out in the order they were written. each run of packets
+    //   for the same socket is one batch, so rtcp never overtakes the rtp
+    //   written before it
+    auto it = packets.cbegin();
+    while (it != packets.cend()) {
+        const int         offset = it->portOffset;
+        const PRtpPacket *batch[UDP_BATCH_MAX];
+        int               count = 0;
+        for (; it != packets.cend() && count < UDP_BATCH_MAX && it->portOffset == offset; ++it)
+            batch[count++] = &(*it);
+
+        int     sent = 0;
+        GError *err  = nullptr;
+#if GLIB_CHECK_VERSION(2, 44, 0)
+        GOutputVector  vectors[UDP_BATCH_MAX];
+        GOutputMessage messages[UDP_BATCH_MAX];
+        for (int n = 0; n < count; ++n) {
+            vectors[n]  = { const_cast<char *>(batch[n]->rawValue.constData()), gsize(batch[n]->rawValue.size()) };
+            messages[n] = { remote[offset], &vectors[n], 1, 0, nullptr, 0 };
+        }
+
+        sent = g_socket_send_messages(sockets[offset], messages, guint(count), 0, nullptr, &err);
+#else
+        for (; sent < count; ++sent) {
+            if (g_socket_send_to(sockets[offset], remote[offset], batch[sent]->rawValue.constData(),
+                                 gsize(batch[sent]->rawValue.size()), nullptr, &err)
+                < 0)
+                break;
+        }
+#endif
+        if (err) {
+            if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+                qWarning("RtpUdpTransport: send failed: %s", err->message);
+            g_error_free(err);
+        }
+        sent = qMax(sent, 0);
+
+        // a full send buffer on a live stream means we're late already,
+        //   so whatever didn't fit is dropped rather than retried
+        sent_.fetch_add(quint64(sent), std::memory_order_relaxed);
+        dropped_.fetch_add(quint64(count - sent), std::memory_order_relaxed);
+    }
+}
+
+gpointer RtpUdpTransport::cb_thread(gpointer data)
+{
+    auto self = static_cast<RtpUdpTransport *>(data);
+    g_main_context_push_thread_default(self->context);
+    g_main_loop_run(self->loop);
+    g_main_context_pop_thread_default(self->context);
+    return nullptr;
+}
+
+gboolean RtpUdpTransport::cb_socket_readable(GSocket *socket, GIOCondition condition, gpointer data)
+{
+    Q_UNUSED(condition);
+    auto self = static_cast<RtpUdpTransport *>(data);
+    self->readPending(socket == self->sockets[0] ? 0 : 1);
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean RtpUdpTransport::cb_write_dispatch(GSource *source, GSourceFunc callback, gpointer data)
+{
+    Q_UNUSED(callback);
+    Q_UNUSED(data);
+
+    // disarm before draining, so a write racing with us re-arms it
+    g_source_set_ready_time(source, -1);
+    reinterpret_cast<UdpWriteSource *>(source)->transport->writePending();
+    return G_SOURCE_CONTINUE;
+}
+
+} // namespace PsiMedia
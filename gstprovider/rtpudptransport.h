@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_RTPUDPTRANSPORT_H
+#define PSIMEDIA_RTPUDPTRANSPORT_H
+
+#include "psimediaprovider.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include <gio/gio.h>
+
+namespace PsiMedia {
+
+// a pair of udp sockets (rtp and rtcp) serviced by a private glib loop on
+//   its own thread. reads and writes are batched, which on linux means
+//   recvmmsg/sendmmsg under the hood. nothing here touches the qt event
+//   loop.
+class RtpUdpTransport {
+public:
+    RtpUdpTransport();
+    ~RtpUdpTransport();
+
+    RtpUdpTransport(const RtpUdpTransport &)            = delete;
+    RtpUdpTransport &operator=(const RtpUdpTransport &) = delete;
+
+    // binds the sockets and starts the i/o thread. returns false if the
+    //   addresses are invalid or the ports can't be bound
+    bool start(const PUdpTransport &params);
+    void stop();
+
+    // safe to call from any thread, never blocks. packets are dropped if
+    //   there is no remote address
+    void write(const PRtpPacket &packet);
+    void write(const QVector<PRtpPacket> &packets);
+
+    // called from the i/o thread with everything one wakeup could read.
+    //   it is not safe to assign callbacks except before starting
+    void (*cb_packetsReady)(const QVector<PRtpPacket> &packets, void *app) = nullptr;
+    void *app                                                              = nullptr;
+
+    quint64 packetsSent() const { return sent_.load(std::memory_order_relaxed); }
+    quint64 packetsReceived() const { return received_.load(std::memory_order_relaxed); }
+    quint64 packetsDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    GMainContext   *context = nullptr;
+    GMainLoop      *loop    = nullptr;
+    GThread        *thread  = nullptr;
+    GSocket        *sockets[2] {};
+    GSocketAddress *remote[2] {};
+    GSource        *readSources[2] {};
+    GSource        *writeSource = nullptr;
+
+    QByteArray          scratch; // receive buffers, only touched by the i/o thread
+    QMutex              out_mutex;
+    QVector<PRtpPacket> out;
+
+    std::atomic<quint64> sent_ { 0 };
+    std::atomic<quint64> received_ { 0 };
+    std::atomic<quint64> dropped_ { 0 };
+
+    void cleanup();
+    void readPending(int offset);
+    void writePending();
+
+    static gpointer cb_thread(gpointer data);
+    static gboolean cb_socket_readable(GSocket *socket, GIOCondition condition, gpointer data);
+    static gboolean cb_write_dispatch(GSource *source, GSourceFunc callback, gpointer data);
+};
+
+} // namespace PsiMedia
+
+#endif // PSIMEDIA_RTPUDPTRANSPORT_H
@@ -23,13 +23,30 @@
 #include <QDir>
 #include <QElapsedTimer>
 #include <QStringList>
+#include <cstdio>
 #include <cstring>
 #include <gst/app/gstappsrc.h>
+#include <gst/video/video-event.h>
 
+#include "binpool.h"
 #include "bins.h"
+#include "codecs.h"
 // #include "devices.h"
 #include "payloadinfo.h"
 #include "pipeline.h"
+#include "rtppacketpool.h"
+
+// packets queued per media before new ones get dropped
+#define INGRESS_PACKET_MAX 512
+#define INGRESS_RTCP_PACKET_MAX 64
+
+// how often rtcp statistics are reported
+#define STATS_INTERVAL 1000
+
+// how often and how long to look for the caps of a send branch added to a
+//   running session
+#define CAPS_WAIT_INTERVAL 20
+#define CAPS_WAIT_MAX 10000
 
 // TODO: support playing from bytearray
 // TODO: support recording
@@ -137,45 +154,52 @@ static void dump_pipeline(GstElement *in, int indent)
 //----------------------------------------------------------------------------
 // RtpWorker
 //----------------------------------------------------------------------------
-static int              worker_refs          = 0;
-static PipelineContext *send_pipelineContext = nullptr;
-static PipelineContext *recv_pipelineContext = nullptr;
-static GstElement      *spipeline            = nullptr;
-static GstElement      *rpipeline            = nullptr;
-// static GstBus *sbus = 0;
-static bool send_in_use = false;
-static bool recv_in_use = false;
-
-static bool      use_shared_clock     = true;
-static GstClock *shared_clock         = nullptr;
-static bool      send_clock_is_shared = false;
-// static bool recv_clock_is_shared = false;
+// a glib source that fires whenever an ingress queue has packets
+struct IngressSource {
+    GSource    parent;
+    RtpWorker *worker;
+};
+
+static bool use_shared_clock()
+{
+    static const bool on = qgetenv("PSI_NO_SHARED_CLOCK").isEmpty();
+    return on;
+}
+
+// outgoing packets view the payloader buffers instead of copying them.
+//   see RtpPacket::rawValue() for the lifetime implications
+static bool use_zero_copy_egress()
+{
+    static const bool on = !qgetenv("PSI_RTP_ZERO_COPY").isEmpty();
+    return on;
+}
 
 RtpWorker::RtpWorker(GMainContext *mainContext, DeviceMonitor *hardwareDeviceMonitor) :
-    mainContext_(mainContext), hardwareDeviceMonitor_(hardwareDeviceMonitor), audioStats(new Stats("audio")),
-    videoStats(new Stats("video"))
+    mainContext_(mainContext), hardwareDeviceMonitor_(hardwareDeviceMonitor), audioIngress(INGRESS_PACKET_MAX),
+    videoIngress(INGRESS_PACKET_MAX), audioRtcpIngress(INGRESS_RTCP_PACKET_MAX),
+    videoRtcpIngress(INGRESS_RTCP_PACKET_MAX), audioStats(new Stats("audio")), videoStats(new Stats("video"))
 {
-    if (worker_refs == 0) {
-        send_pipelineContext = new PipelineContext;
-        recv_pipelineContext = new PipelineContext;
+    static GSourceFuncs ingressFuncs
+        = { cb_ingress_prepare, cb_ingress_check, cb_ingress_dispatch, nullptr, nullptr, nullptr };
+    ingressSource = g_source_new(&ingressFuncs, sizeof(IngressSource));
+    reinterpret_cast<IngressSource *>(ingressSource)->worker = this;
+    g_source_attach(ingressSource, mainContext_);
 
-        spipeline = send_pipelineContext->element();
-        rpipeline = recv_pipelineContext->element();
+    // every session gets pipelines of its own, so any number of them can
+    //   run side by side
+    send_pipelineContext = new PipelineContext;
+    recv_pipelineContext = new PipelineContext;
+
+    spipeline = send_pipelineContext->element();
+    rpipeline = recv_pipelineContext->element();
 
 #ifdef RTPWORKER_DEBUG
-        /*sbus = gst_pipeline_get_bus(GST_PIPELINE(spipeline));
-        GSource *source = gst_bus_create_watch(bus);
-        gst_object_unref(bus);
-        g_source_set_callback(source, (GSourceFunc)cb_bus_call, this, nullptr);
-        g_source_attach(source, mainContext_);*/
+    /*sbus = gst_pipeline_get_bus(GST_PIPELINE(spipeline));
+    GSource *source = gst_bus_create_watch(bus);
+    gst_object_unref(bus);
+    g_source_set_callback(source, (GSourceFunc)cb_bus_call, this, nullptr);
+    g_source_attach(source, mainContext_);*/
 #endif
-
-        QByteArray val = qgetenv("PSI_NO_SHARED_CLOCK");
-        if (!val.isEmpty())
-            use_shared_clock = false;
-    }
-
-    ++worker_refs;
 }
 
 RtpWorker::~RtpWorker()
@@ -193,16 +217,17 @@ RtpWorker::~RtpWorker()
 
     cleanup();
 
-    --worker_refs;
-    if (worker_refs == 0) {
-        delete send_pipelineContext;
-        send_pipelineContext = nullptr;
+    g_source_destroy(ingressSource);
+    g_source_unref(ingressSource);
+    ingressSource = nullptr;
 
-        delete recv_pipelineContext;
-        recv_pipelineContext = nullptr;
+    delete send_pipelineContext;
+    send_pipelineContext = nullptr;
+    spipeline            = nullptr;
 
-        // sbus = 0;
-    }
+    delete recv_pipelineContext;
+    recv_pipelineContext = nullptr;
+    rpipeline            = nullptr;
 
     delete audioStats;
     delete videoStats;
@@ -221,13 +246,57 @@ void RtpWorker::cleanup()
     volumeout = nullptr;
     volumeout_mutex.unlock();
 
-    audiortpsrc_mutex.lock();
-    audiortpsrc = nullptr;
-    audiortpsrc_mutex.unlock();
+    rtpaudioout_mutex.lock();
+    audiovalve = nullptr;
+    rtpaudioout_mutex.unlock();
 
-    videortpsrc_mutex.lock();
-    videortpsrc = nullptr;
-    videortpsrc_mutex.unlock();
+    rtpvideoout_mutex.lock();
+    videovalve = nullptr;
+    rtpvideoout_mutex.unlock();
+
+    if (statsTimer) {
+        g_source_destroy(statsTimer);
+        g_source_unref(statsTimer);
+        statsTimer = nullptr;
+    }
+    if (capsTimer) {
+        g_source_destroy(capsTimer);
+        g_source_unref(capsTimer);
+        capsTimer = nullptr;
+    }
+    participants_mutex.lock();
+    if (participantsTimer) {
+        g_source_destroy(participantsTimer);
+        g_source_unref(participantsTimer);
+        participantsTimer = nullptr;
+    }
+    leftParticipants.clear();
+    participants_mutex.unlock();
+    pendingCaps[0]     = false;
+    pendingCaps[1]     = false;
+    audioInLastPackets = 0;
+    videoInLastPackets = 0;
+    audioInLastLost    = 0;
+    videoInLastLost    = 0;
+    resetSyncPoint(0);
+    resetSyncPoint(1);
+
+    audiortpsrc       = nullptr;
+    videortpsrc       = nullptr;
+    audiortcpsrc_send = nullptr;
+    videortcpsrc_send = nullptr;
+    audiortcpsrc_recv = nullptr;
+    videortcpsrc_recv = nullptr;
+    audioIngress.clear();
+    videoIngress.clear();
+    audioRtcpIngress.clear();
+    videoRtcpIngress.clear();
+#ifdef RTPWORKER_DEBUG
+    qDebug("ingress: audio %llu queued/%llu dropped, video %llu queued/%llu dropped", audioIngress.enqueued(),
+           audioIngress.dropped(), videoIngress.enqueued(), videoIngress.dropped());
+    RtpPacketPool::Stats poolStats = RtpPacketPool::instance()->stats();
+    qDebug("packet pool: %llu hits/%llu misses", poolStats.hits, poolStats.misses);
+#endif
 
     rtpaudioout_mutex.lock();
     rtpaudioout = false;
@@ -244,24 +313,12 @@ void RtpWorker::cleanup()
     //    pd_videosrc->deactivate();
 
     if (sendbin) {
+        // the receive pipeline, if any, is torn down next and reverts to
+        //   its own clock there
         if (shared_clock && send_clock_is_shared) {
             gst_object_unref(shared_clock);
             shared_clock         = nullptr;
             send_clock_is_shared = false;
-
-            if (recv_in_use) {
-                qDebug("recv clock reverts to auto");
-                gst_element_set_state(rpipeline, GST_STATE_READY);
-                gst_element_get_state(rpipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
-                gst_pipeline_auto_clock(GST_PIPELINE(rpipeline));
-
-                // only restart the receive pipeline if it is
-                //   owned by a separate session
-                if (!recvbin) {
-                    gst_element_set_state(rpipeline, GST_STATE_PLAYING);
-                    // gst_element_get_state(rpipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
-                }
-            }
         }
 
         send_pipelineContext->deactivate();
@@ -269,8 +326,10 @@ void RtpWorker::cleanup()
         // gst_element_set_state(sendbin, GST_STATE_NULL);
         // gst_element_get_state(sendbin, nullptr, nullptr, GST_CLOCK_TIME_NONE);
         gst_bin_remove(GST_BIN(spipeline), sendbin);
-        sendbin     = nullptr;
-        send_in_use = false;
+        sendbin    = nullptr;
+        sendrtpbin = nullptr;
+        sendBranch[0].clear();
+        sendBranch[1].clear();
     }
 
     if (recvbin) {
@@ -306,7 +365,16 @@ void RtpWorker::cleanup()
         // gst_element_get_state(recvbin, nullptr, nullptr, GST_CLOCK_TIME_NONE);
         gst_bin_remove(GST_BIN(rpipeline), recvbin);
         recvbin     = nullptr;
-        recv_in_use = false;
+        recvrtpbin  = nullptr;
+        audiodecbin = nullptr;
+        videodecbin = nullptr;
+        recvBranch[0].clear();
+        recvBranch[1].clear();
+
+        // the participant elements went away with recvbin
+        QMutexLocker locker(&participants_mutex);
+        participants.clear();
+        audiomixer = nullptr;
     }
 
     if (pd_audiosrc) {
@@ -325,6 +393,7 @@ void RtpWorker::cleanup()
         delete pd_audiosink;
         pd_audiosink = nullptr;
     }
+    held = false;
 
 #ifdef RTPWORKER_DEBUG
     qDebug("cleaning done.");
@@ -334,6 +403,7 @@ void RtpWorker::cleanup()
 void RtpWorker::start()
 {
     Q_ASSERT(!timer);
+    startRequested = PRtpPacket::currentTime();
     timer = g_timeout_source_new(0);
     g_source_set_callback(timer, cb_doStart, this, nullptr);
     g_source_attach(timer, mainContext_);
@@ -347,28 +417,53 @@ void RtpWorker::update()
     g_source_attach(timer, mainContext_);
 }
 
+// asks the encoder of an encoder bin for a keyframe as soon as possible
+static void forceKeyframe(GstElement *encbin)
+{
+    GstPad *pad = gst_element_get_static_pad(encbin, "src");
+    gst_pad_send_event(pad, gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0));
+    gst_object_unref(GST_OBJECT(pad));
+}
+
+// the valves are open until the payloaders have negotiated, see
+//   cb_audio_negotiated()
 void RtpWorker::transmitAudio()
 {
     QMutexLocker locker(&rtpaudioout_mutex);
     rtpaudioout = true;
+    if (audiovalve)
+        g_object_set(G_OBJECT(audiovalve), "drop", FALSE, nullptr);
 }
 
 void RtpWorker::transmitVideo()
 {
     QMutexLocker locker(&rtpvideoout_mutex);
     rtpvideoout = true;
+    if (videovalve) {
+        gboolean paused = FALSE;
+        g_object_get(G_OBJECT(videovalve), "drop", &paused, nullptr);
+        g_object_set(G_OBJECT(videovalve), "drop", FALSE, nullptr);
+
+        // whatever the peer decoded last is long gone
+        if (paused && videortppay)
+            forceKeyframe(videortppay);
+    }
 }
 
 void RtpWorker::pauseAudio()
 {
     QMutexLocker locker(&rtpaudioout_mutex);
     rtpaudioout = false;
+    if (audiovalve)
+        g_object_set(G_OBJECT(audiovalve), "drop", TRUE, nullptr);
 }
 
 void RtpWorker::pauseVideo()
 {
     QMutexLocker locker(&rtpvideoout_mutex);
     rtpvideoout = false;
+    if (videovalve)
+        g_object_set(G_OBJECT(videovalve), "drop", TRUE, nullptr);
 }
 
 void RtpWorker::stop()
@@ -382,27 +477,46 @@ void RtpWorker::stop()
     g_source_attach(timer, mainContext_);
 }
 
-static GstBuffer *makeGstBuffer(const PRtpPacket &packet)
+// wraps the packet storage into a gst buffer without copying the payload
+static GstBuffer *makeGstBuffer(const PRtpPacket &packet) { return RtpPacketPool::instance()->wrap(packet); }
+
+// with zero copy egress the packet views the mapped buffer, otherwise the
+//   payload is copied out
+static PRtpPacket makeRtpPacket(GstBuffer *buffer)
 {
-    GstBuffer *buffer;
-    GstMemory *memory;
-    GstMapInfo info;
-    buffer = gst_buffer_new();
-    memory = gst_allocator_alloc(nullptr, gsize(packet.rawValue.size()), nullptr);
-    if (buffer && memory) {
-        gst_memory_map(memory, &info, GST_MAP_WRITE);
-        std::memcpy(info.data, packet.rawValue.data(), size_t(packet.rawValue.size()));
-        gst_memory_unmap(memory, &info);
-        gst_buffer_insert_memory(buffer, -1, memory);
-        return buffer;
-    }
-    if (memory) {
-        gst_allocator_free(nullptr, memory);
-    }
-    if (buffer) {
-        gst_buffer_unref(buffer);
-    }
-    return nullptr;
+    return RtpPacketPool::instance()->fromBuffer(buffer, use_zero_copy_egress());
+}
+
+// the packet clock time at which the element's pipeline had a running
+//   time of zero, or -1 if it has no clock yet
+static qint64 pipelineEpoch(GstElement *element)
+{
+    GstClock *clock = gst_element_get_clock(element);
+    if (!clock)
+        return -1;
+
+    qint64 now = qint64(gst_clock_get_time(clock));
+    gst_object_unref(clock);
+    qint64 running = (now - qint64(gst_element_get_base_time(element))) / 1000;
+    return PRtpPacket::currentTime() - running;
+}
+
+// when the media of an outgoing buffer was captured. a wall clock
+//   reference timestamp from the source wins, otherwise the buffer's
+//   running time is used
+static qint64 captureTime(GstBuffer *buffer, qint64 epoch)
+{
+#if GST_CHECK_VERSION(1, 14, 0)
+    static GstCaps            *unixCaps = gst_caps_new_empty_simple("timestamp/x-unix");
+    GstReferenceTimestampMeta *meta     = gst_buffer_get_reference_timestamp_meta(buffer, unixCaps);
+    if (meta)
+        return qint64(meta->timestamp / 1000) - g_get_real_time() + PRtpPacket::currentTime();
+#endif
+
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (epoch < 0 || !GST_CLOCK_TIME_IS_VALID(pts))
+        return -1;
+    return epoch + qint64(pts / 1000);
 }
 
 GstAppSink *RtpWorker::makeVideoPlayAppSink(const gchar *name)
@@ -418,19 +532,109 @@ GstAppSink *RtpWorker::makeVideoPlayAppSink(const gchar *name)
     return appVideoSink;
 }
 
-void RtpWorker::rtpAudioIn(const PRtpPacket &packet)
+// returns true if the worker needs a wakeup
+static bool pushPacket(RtpIngressQueue &rtp, RtpIngressQueue &rtcp, const PRtpPacket &packet)
+{
+    RtpIngressQueue *queue;
+    if (packet.portOffset == 0)
+        queue = &rtp;
+    else if (packet.portOffset == 1)
+        queue = &rtcp;
+    else
+        return false;
+
+    GstBuffer *buffer = makeGstBuffer(packet);
+    return buffer && queue->push(buffer);
+}
+
+// queues the whole batch and wakes the worker at most once
+static bool pushBatch(RtpIngressQueue &rtp, RtpIngressQueue &rtcp, const QVector<PRtpPacket> &packets)
 {
-    QMutexLocker locker(&audiortpsrc_mutex);
-    if (packet.portOffset == 0 && audiortpsrc) {
-        gst_app_src_push_buffer((GstAppSrc *)audiortpsrc, makeGstBuffer(packet));
+    bool wake = false;
+    for (const PRtpPacket &packet : packets) {
+        if (pushPacket(rtp, rtcp, packet))
+            wake = true;
     }
+    return wake;
+}
+
+void RtpWorker::rtpAudioIn(const PRtpPacket &packet)
+{
+    if (pushPacket(audioIngress, audioRtcpIngress, packet))
+        g_main_context_wakeup(mainContext_);
 }
 
 void RtpWorker::rtpVideoIn(const PRtpPacket &packet)
 {
-    QMutexLocker locker(&videortpsrc_mutex);
-    if (packet.portOffset == 0 && videortpsrc)
-        gst_app_src_push_buffer((GstAppSrc *)videortpsrc, makeGstBuffer(packet));
+    if (pushPacket(videoIngress, videoRtcpIngress, packet))
+        g_main_context_wakeup(mainContext_);
+}
+
+void RtpWorker::rtpAudioIn(const QVector<PRtpPacket> &packets)
+{
+    if (pushBatch(audioIngress, audioRtcpIngress, packets))
+        g_main_context_wakeup(mainContext_);
+}
+
+void RtpWorker::rtpVideoIn(const QVector<PRtpPacket> &packets)
+{
+    if (pushBatch(videoIngress, videoRtcpIngress, packets))
+        g_main_context_wakeup(mainContext_);
+}
+
+RtpWorker::IngressStats RtpWorker::audioIngressStats() const
+{
+    IngressStats stats;
+    stats.enqueued = audioIngress.enqueued();
+    stats.dropped  = audioIngress.dropped();
+    return stats;
+}
+
+RtpWorker::IngressStats RtpWorker::videoIngressStats() const
+{
+    IngressStats stats;
+    stats.enqueued = videoIngress.enqueued();
+    stats.dropped  = videoIngress.dropped();
+    return stats;
+}
+
+static void pushBufferList(GstElement *appsrc, GstBufferList *list)
+{
+#if GST_CHECK_VERSION(1, 14, 0)
+    gst_app_src_push_buffer_list(GST_APP_SRC(appsrc), list);
+#else
+    guint count = gst_buffer_list_length(list);
+    for (guint n = 0; n < count; ++n)
+        gst_app_src_push_buffer(GST_APP_SRC(appsrc), gst_buffer_ref(gst_buffer_list_get(list, n)));
+    gst_buffer_list_unref(list);
+#endif
+}
+
+// the list goes to whichever of the appsrcs exist, or is dropped
+static void pushBufferList(GstElement *first, GstElement *second, GstBufferList *list)
+{
+    if (!list)
+        return;
+
+    if (first && second)
+        pushBufferList(first, gst_buffer_list_ref(list));
+    else if (first)
+        second = first;
+
+    if (second)
+        pushBufferList(second, list);
+    else
+        gst_buffer_list_unref(list);
+}
+
+// executed in the worker thread. whatever arrived while nobody was
+//   listening (no recvbin yet, or already torn down) is discarded
+void RtpWorker::flushIngress()
+{
+    pushBufferList(audiortpsrc, nullptr, audioIngress.takeAll());
+    pushBufferList(videortpsrc, nullptr, videoIngress.takeAll());
+    pushBufferList(audiortcpsrc_send, audiortcpsrc_recv, audioRtcpIngress.takeAll());
+    pushBufferList(videortcpsrc_send, videortcpsrc_recv, videoRtcpIngress.takeAll());
 }
 
 void RtpWorker::setOutputVolume(int level)
@@ -453,6 +657,243 @@ void RtpWorker::setInputVolume(int level)
     }
 }
 
+void RtpWorker::switchDevices()
+{
+    bool sendClockLost = false;
+    bool recvClockLost = false;
+    bool lost          = false;
+
+    if (pd_audiosrc && !ain.isEmpty() && ain != pd_audiosrc->id()) {
+        if (!pd_audiosrc->switchDevice(ain, hardwareDeviceMonitor_, &lost))
+            qWarning("unable to switch audio input to [%s]", qPrintable(ain));
+        sendClockLost |= lost;
+    }
+    if (pd_videosrc && !vin.isEmpty() && vin != pd_videosrc->id()) {
+        if (!pd_videosrc->switchDevice(vin, hardwareDeviceMonitor_, &lost))
+            qWarning("unable to switch video input to [%s]", qPrintable(vin));
+        sendClockLost |= lost;
+    }
+    if (pd_audiosink && !aout.isEmpty() && aout != pd_audiosink->id()) {
+        if (!pd_audiosink->switchDevice(aout, hardwareDeviceMonitor_, &lost))
+            qWarning("unable to switch audio output to [%s]", qPrintable(aout));
+        recvClockLost |= lost;
+    }
+
+    if (sendClockLost)
+        replaceClock(spipeline);
+    if (recvClockLost)
+        replaceClock(rpipeline);
+}
+
+// the pipeline was running on the clock of a device that has been switched
+//   away, which stops advancing. a new clock is selected on the way back to
+//   PLAYING, and handed on to the receive pipeline if it is shared
+void RtpWorker::replaceClock(GstElement *pipeline)
+{
+#ifdef RTPWORKER_DEBUG
+    qDebug("replacing the clock of the %s pipeline", pipeline == spipeline ? "send" : "recv");
+#endif
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    gst_pipeline_auto_clock(GST_PIPELINE(pipeline));
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    gst_element_get_state(pipeline, nullptr, nullptr, GST_SECOND);
+
+    if (pipeline != spipeline || !send_clock_is_shared)
+        return;
+
+    gst_object_unref(shared_clock);
+    shared_clock = gst_pipeline_get_clock(GST_PIPELINE(spipeline));
+    gst_pipeline_use_clock(GST_PIPELINE(spipeline), shared_clock);
+
+    if (recvbin) {
+        gst_element_set_state(rpipeline, GST_STATE_PAUSED);
+        gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
+        gst_element_set_state(rpipeline, GST_STATE_PLAYING);
+    }
+}
+
+void RtpWorker::hold()
+{
+    if (held || fileDemux || (!sendbin && !recvbin))
+        return;
+
+#ifdef RTPWORKER_DEBUG
+    qDebug("holding");
+#endif
+    held = true;
+
+    // nothing moves in READY, so the devices can be taken out without
+    //   blocking anything first. the loop may be shared with other
+    //   sessions, so a device that doesn't get there in time is an error
+    //   rather than something to wait on
+    bool ready = true;
+    if (sendbin) {
+        gst_element_set_state(spipeline, GST_STATE_READY);
+        ready = gst_element_get_state(spipeline, nullptr, nullptr, 10 * GST_SECOND) == GST_STATE_CHANGE_SUCCESS;
+    }
+    if (recvbin && ready) {
+        gst_element_set_state(rpipeline, GST_STATE_READY);
+        ready = gst_element_get_state(rpipeline, nullptr, nullptr, 10 * GST_SECOND) == GST_STATE_CHANGE_SUCCESS;
+    }
+    if (!ready) {
+#ifdef RTPWORKER_DEBUG
+        qDebug("error/timeout while holding");
+#endif
+        error = RtpSessionContext::ErrorGeneric;
+        if (cb_error)
+            cb_error(app);
+        return;
+    }
+
+    // the shared clock is usually the one of the audio input, which is
+    //   about to go away
+    if (shared_clock && send_clock_is_shared) {
+        gst_pipeline_auto_clock(GST_PIPELINE(spipeline));
+        gst_pipeline_auto_clock(GST_PIPELINE(rpipeline));
+        gst_object_unref(shared_clock);
+        shared_clock         = nullptr;
+        send_clock_is_shared = false;
+    }
+
+    if (pd_audiosrc) {
+        gst_element_unlink(audiosrc, sendbin);
+        delete pd_audiosrc;
+        pd_audiosrc = nullptr;
+        audiosrc    = nullptr;
+    }
+    if (pd_videosrc) {
+        gst_element_unlink(videosrc, sendbin);
+        delete pd_videosrc;
+        pd_videosrc = nullptr;
+        videosrc    = nullptr;
+    }
+    if (pd_audiosink) {
+        gst_element_unlink(recvbin, pd_audiosink->element());
+        delete pd_audiosink;
+        pd_audiosink = nullptr;
+    }
+}
+
+void RtpWorker::resume()
+{
+    if (!held)
+        return;
+
+#ifdef RTPWORKER_DEBUG
+    qDebug("resuming");
+#endif
+    held = false;
+
+    if (!reopenDevices()) {
+        if (cb_error)
+            cb_error(app);
+        return;
+    }
+
+    if (sendbin) {
+        gst_element_set_state(spipeline, GST_STATE_PLAYING);
+        gst_element_get_state(spipeline, nullptr, nullptr, 10 * GST_SECOND);
+
+        if (!shared_clock && use_shared_clock()) {
+            shared_clock = gst_pipeline_get_clock(GST_PIPELINE(spipeline));
+            gst_pipeline_use_clock(GST_PIPELINE(spipeline), shared_clock);
+            send_clock_is_shared = true;
+        }
+    }
+    if (recvbin) {
+        if (shared_clock && send_clock_is_shared)
+            gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
+        gst_element_set_state(rpipeline, GST_STATE_PLAYING);
+    }
+
+    // catch up with media and devices that were changed while held
+    if (!setupSendRecv()) {
+        if (cb_error)
+            cb_error(app);
+    }
+}
+
+// puts the devices released by hold() back where they were. the branches
+//   themselves never went away
+bool RtpWorker::reopenDevices()
+{
+    // playback first, echo cancellation of the input depends on it
+    GstPad *ghost = recvbin ? gst_element_get_static_pad(recvbin, "src") : nullptr;
+    if (ghost) {
+        gst_object_unref(ghost);
+        pd_audiosink
+            = PipelineDeviceContext::create(recv_pipelineContext, aout, PDevice::AudioOut, hardwareDeviceMonitor_);
+        if (!pd_audiosink) {
+#ifdef RTPWORKER_DEBUG
+            qDebug("Failed to reopen audio output element '%s'.", qPrintable(aout));
+#endif
+            error = RtpSessionContext::ErrorGeneric;
+            return false;
+        }
+        gst_element_link(recvbin, pd_audiosink->element());
+    }
+
+    if (!sendbin)
+        return true;
+
+    if (audiortppay && !ain.isEmpty() && !localAudioParams.isEmpty()) {
+        PipelineDeviceOptions opts;
+        if (pd_audiosink) {
+            opts     = pd_audiosink->options();
+            opts.aec = !opts.echoProberName.isEmpty();
+        }
+
+        pd_audiosrc = PipelineDeviceContext::create(send_pipelineContext, ain, PDevice::AudioIn,
+                                                    hardwareDeviceMonitor_, opts);
+        if (!pd_audiosrc) {
+#ifdef RTPWORKER_DEBUG
+            qDebug("Failed to reopen audio input element '%s'.", qPrintable(ain));
+#endif
+            error = RtpSessionContext::ErrorGeneric;
+            return false;
+        }
+        audiosrc = pd_audiosrc->element();
+        gst_element_link_pads(audiosrc, "src", sendbin, "sink0");
+    }
+
+    if (videortppay && !vin.isEmpty() && !localVideoParams.isEmpty()) {
+        PipelineDeviceOptions opts;
+        opts.videoSize = localVideoParams[0].size;
+        opts.fps       = 30;
+
+        pd_videosrc = PipelineDeviceContext::create(send_pipelineContext, vin, PDevice::VideoIn,
+                                                    hardwareDeviceMonitor_, opts);
+        if (!pd_videosrc) {
+#ifdef RTPWORKER_DEBUG
+            qDebug("Failed to reopen video input element '%s'.", qPrintable(vin));
+#endif
+            error = RtpSessionContext::ErrorGeneric;
+            return false;
+        }
+        videosrc = pd_videosrc->element();
+        gst_element_link_pads(videosrc, "src", sendbin, "sink1");
+    }
+
+    return true;
+}
+
+void RtpWorker::setParticipantVolumes(const QMap<quint32, int> &volumes, const QSet<quint32> &muted)
+{
+    QMutexLocker locker(&participants_mutex);
+    participantVolumes = volumes;
+    mutedParticipants  = muted;
+    for (auto it = participants.cbegin(); it != participants.cend(); ++it)
+        applyParticipantVolume(it.key(), it.value());
+}
+
+// participants_mutex must be held
+void RtpWorker::applyParticipantVolume(quint32 ssrc, const Participant &p)
+{
+    double   vol  = double(participantVolumes.value(ssrc, 100)) / 100;
+    gboolean mute = mutedParticipants.contains(ssrc) ? TRUE : FALSE;
+    g_object_set(G_OBJECT(p.volume), "volume", vol, "mute", mute, nullptr);
+}
+
 void RtpWorker::recordStart()
 {
     // FIXME: for now we just send EOF/error
@@ -471,13 +912,17 @@ void RtpWorker::dumpPipeline(std::function<void(const QStringList &)> callback)
     QStringList ret;
     auto        dir = QString::fromLocal8Bit(qgetenv("GST_DEBUG_DUMP_DOT_DIR"));
     if (!dir.isEmpty()) {
+        // one pair of files per session
+        QString    suffix   = QString::number(quintptr(this), 16);
+        QByteArray sendName = QString("psimedia_send_" + suffix).toUtf8();
+        QByteArray recvName = QString("psimedia_recv_" + suffix).toUtf8();
         if (spipeline) {
-            GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(spipeline), GST_DEBUG_GRAPH_SHOW_ALL, "psimedia_send");
-            ret << QDir::toNativeSeparators(dir + "/psimedia_send.dot");
+            GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(spipeline), GST_DEBUG_GRAPH_SHOW_ALL, sendName.constData());
+            ret << QDir::toNativeSeparators(dir + "/" + QString::fromUtf8(sendName) + ".dot");
         }
         if (rpipeline) {
-            GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(rpipeline), GST_DEBUG_GRAPH_SHOW_ALL, "psimedia_recv");
-            ret << QDir::toNativeSeparators(dir + "/psimedia_recv.dot");
+            GST_DEBUG_BIN_TO_DOT_FILE(GST_BIN(rpipeline), GST_DEBUG_GRAPH_SHOW_ALL, recvName.constData());
+            ret << QDir::toNativeSeparators(dir + "/" + QString::fromUtf8(recvName) + ".dot");
         }
     }
     if (callback) {
@@ -531,6 +976,16 @@ GstFlowReturn RtpWorker::cb_packet_ready_rtp_video(GstAppSink *appsink, gpointer
     return static_cast<RtpWorker *>(data)->packet_ready_rtp_video(appsink);
 }
 
+GstFlowReturn RtpWorker::cb_packet_ready_rtcp_audio(GstAppSink *appsink, gpointer data)
+{
+    return static_cast<RtpWorker *>(data)->packet_ready_rtcp_audio(appsink);
+}
+
+GstFlowReturn RtpWorker::cb_packet_ready_rtcp_video(GstAppSink *appsink, gpointer data)
+{
+    return static_cast<RtpWorker *>(data)->packet_ready_rtcp_video(appsink);
+}
+
 GstFlowReturn RtpWorker::cb_packet_ready_preroll_stub(GstAppSink *appsink, gpointer data)
 {
     Q_UNUSED(appsink)
@@ -565,6 +1020,106 @@ void RtpWorker::cb_packet_ready_eos_stub(GstAppSink *appsink, gpointer data)
 
 gboolean RtpWorker::cb_fileReady(gpointer data) { return static_cast<RtpWorker *>(data)->fileReady(); }
 
+gboolean RtpWorker::cb_ingress_prepare(GSource *source, gint *timeout)
+{
+    *timeout = -1;
+    return cb_ingress_check(source);
+}
+
+gboolean RtpWorker::cb_ingress_check(GSource *source)
+{
+    auto worker = reinterpret_cast<IngressSource *>(source)->worker;
+    return worker->audioIngress.isEmpty() && worker->videoIngress.isEmpty() && worker->audioRtcpIngress.isEmpty()
+            && worker->videoRtcpIngress.isEmpty()
+        ? FALSE
+        : TRUE;
+}
+
+gboolean RtpWorker::cb_ingress_dispatch(GSource *source, GSourceFunc callback, gpointer data)
+{
+    Q_UNUSED(callback)
+    Q_UNUSED(data)
+    reinterpret_cast<IngressSource *>(source)->worker->flushIngress();
+    return TRUE;
+}
+
+void RtpWorker::cb_recvrtpbin_pad_added(GstElement *element, GstPad *pad, gpointer data)
+{
+    static_cast<RtpWorker *>(data)->recvrtpbin_pad_added(element, pad);
+}
+
+GstCaps *RtpWorker::cb_recvrtpbin_request_pt_map(GstElement *element, guint session, guint pt, gpointer data)
+{
+    Q_UNUSED(element)
+    return static_cast<RtpWorker *>(data)->recvrtpbin_request_pt_map(session, pt);
+}
+
+void RtpWorker::cb_recvrtpbin_ssrc_left(GstElement *element, guint session, guint ssrc, gpointer data)
+{
+    Q_UNUSED(element)
+    if (session == 0)
+        static_cast<RtpWorker *>(data)->participantLeft(ssrc);
+}
+
+gboolean RtpWorker::cb_removeParticipants(gpointer data) { return static_cast<RtpWorker *>(data)->removeParticipants(); }
+
+gboolean RtpWorker::cb_statsTimeout(gpointer data) { return static_cast<RtpWorker *>(data)->statsTimeout(); }
+
+gboolean RtpWorker::cb_capsTimeout(gpointer data) { return static_cast<RtpWorker *>(data)->capsTimeout(); }
+
+GstPadProbeReturn RtpWorker::cb_sync_audio(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    static_cast<RtpWorker *>(data)->updateSyncPoint(0, pad, GST_PAD_PROBE_INFO_BUFFER(info));
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn RtpWorker::cb_sync_video(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    static_cast<RtpWorker *>(data)->updateSyncPoint(1, pad, GST_PAD_PROBE_INFO_BUFFER(info));
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn RtpWorker::cb_play_audio(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    static_cast<RtpWorker *>(data)->updatePlayPoint(0, pad, GST_PAD_PROBE_INFO_BUFFER(info));
+    return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn RtpWorker::cb_play_video(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    static_cast<RtpWorker *>(data)->updatePlayPoint(1, pad, GST_PAD_PROBE_INFO_BUFFER(info));
+    return GST_PAD_PROBE_OK;
+}
+
+// the first caps out of a payloader. from then on its valve follows
+//   transmission, and stays closed until the first transmitAudio() or
+//   transmitVideo()
+GstPadProbeReturn RtpWorker::cb_audio_negotiated(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    Q_UNUSED(pad)
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_CAPS)
+        return GST_PAD_PROBE_OK;
+
+    auto         self = static_cast<RtpWorker *>(data);
+    QMutexLocker locker(&self->rtpaudioout_mutex);
+    if (self->audiovalve)
+        g_object_set(G_OBJECT(self->audiovalve), "drop", !self->rtpaudioout, nullptr);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+GstPadProbeReturn RtpWorker::cb_video_negotiated(GstPad *pad, GstPadProbeInfo *info, gpointer data)
+{
+    Q_UNUSED(pad)
+    if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_CAPS)
+        return GST_PAD_PROBE_OK;
+
+    auto         self = static_cast<RtpWorker *>(data);
+    QMutexLocker locker(&self->rtpvideoout_mutex);
+    if (self->videovalve)
+        g_object_set(G_OBJECT(self->videovalve), "drop", !self->rtpvideoout, nullptr);
+    return GST_PAD_PROBE_REMOVE;
+}
+
 gboolean RtpWorker::doStart()
 {
     timer = nullptr;
@@ -586,8 +1141,8 @@ gboolean RtpWorker::doStart()
             cb_error(app);
     } else {
         // don't signal started here if using files
-        if (!fileDemux && cb_started)
-            cb_started(app);
+        if (!fileDemux)
+            signalStarted();
     }
 
     return FALSE;
@@ -600,7 +1155,8 @@ gboolean RtpWorker::doUpdate()
     if (!setupSendRecv()) {
         if (cb_error)
             cb_error(app);
-    } else {
+    } else if (!capsTimer) {
+        // otherwise capsTimeout() reports back once the new media runs
         if (cb_updated)
             cb_updated(app);
     }
@@ -820,16 +1376,10 @@ GstFlowReturn RtpWorker::packet_ready_rtp_audio(GstAppSink *appsink)
 {
     GstSample *sample = gst_app_sink_pull_sample(appsink);
     GstBuffer *buffer = gst_sample_get_buffer(sample);
-    int        sz     = int(gst_buffer_get_size(buffer));
-    QByteArray ba;
-    ba.resize(sz);
-    gst_buffer_extract(buffer, 0, ba.data(), gsize(sz));
+    PRtpPacket packet = makeRtpPacket(buffer);
+    packet.timestamp  = captureTime(buffer, pipelineEpoch(GST_ELEMENT(appsink)));
     gst_sample_unref(sample);
 
-    PRtpPacket packet;
-    packet.rawValue   = ba;
-    packet.portOffset = 0;
-
 #ifdef RTPWORKER_DEBUG
     audioStats->print_stats(packet.rawValue.size());
 #endif
@@ -844,31 +1394,650 @@ GstFlowReturn RtpWorker::packet_ready_rtp_audio(GstAppSink *appsink)
 GstFlowReturn RtpWorker::packet_ready_rtp_video(GstAppSink *appsink)
 {
     GstSample *sample = gst_app_sink_pull_sample(appsink);
-    GstBuffer *buffer = gst_sample_get_buffer(sample);
-    int        sz     = int(gst_buffer_get_size(buffer));
-    QByteArray ba;
-    ba.resize(sz);
-    gst_buffer_extract(buffer, 0, ba.data(), gsize(sz));
-    gst_sample_unref(sample);
 
-    PRtpPacket packet;
-    packet.rawValue   = ba;
-    packet.portOffset = 0;
+    // the payloader pushes each frame as a buffer list, which the appsink
+    //   hands over whole
+    QVector<PRtpPacket> packets;
+    GstBufferList      *list  = nullptr;
+    qint64              epoch = pipelineEpoch(GST_ELEMENT(appsink));
+#if GST_CHECK_VERSION(1, 12, 0)
+    list = gst_sample_get_buffer_list(sample);
+#endif
+    if (list) {
+        guint count = gst_buffer_list_length(list);
+        packets.reserve(int(count));
+        for (guint n = 0; n < count; ++n) {
+            GstBuffer *buffer = gst_buffer_list_get(list, n);
+            packets += makeRtpPacket(buffer);
+            packets.last().timestamp = captureTime(buffer, epoch);
+        }
+    } else {
+        GstBuffer *buffer = gst_sample_get_buffer(sample);
+        packets += makeRtpPacket(buffer);
+        packets.last().timestamp = captureTime(buffer, epoch);
+    }
+    gst_sample_unref(sample);
 
 #ifdef RTPWORKER_DEBUG
-    videoStats->print_stats(packet.rawValue.size());
+    for (const PRtpPacket &packet : std::as_const(packets))
+        videoStats->print_stats(packet.rawValue.size());
 #endif
 
     QMutexLocker locker(&rtpvideoout_mutex);
-    if (cb_rtpVideoOut && rtpvideoout)
-        cb_rtpVideoOut(packet, app);
+    if (!rtpvideoout)
+        return GST_FLOW_OK;
+
+    if (cb_rtpVideoOutBatch)
+        cb_rtpVideoOutBatch(packets, app);
+    else if (cb_rtpVideoOut) {
+        for (const PRtpPacket &packet : std::as_const(packets))
+            cb_rtpVideoOut(packet, app);
+    }
 
     return GST_FLOW_OK;
 }
 
-gboolean RtpWorker::fileReady()
+// rtcp goes out regardless of transmit state, since the receiver reports
+//   are needed by the peer even if we don't send any media
+GstFlowReturn RtpWorker::packet_ready_rtcp_audio(GstAppSink *appsink)
 {
-    if (loopFile) {
+    GstSample *sample = gst_app_sink_pull_sample(appsink);
+    PRtpPacket packet = makeRtpPacket(gst_sample_get_buffer(sample));
+    gst_sample_unref(sample);
+    packet.portOffset = 1;
+
+    QMutexLocker locker(&rtpaudioout_mutex);
+    if (cb_rtpAudioOut)
+        cb_rtpAudioOut(packet, app);
+
+    return GST_FLOW_OK;
+}
+
+GstFlowReturn RtpWorker::packet_ready_rtcp_video(GstAppSink *appsink)
+{
+    GstSample *sample = gst_app_sink_pull_sample(appsink);
+    PRtpPacket packet = makeRtpPacket(gst_sample_get_buffer(sample));
+    gst_sample_unref(sample);
+    packet.portOffset = 1;
+
+    QMutexLocker locker(&rtpvideoout_mutex);
+    if (cb_rtpVideoOut)
+        cb_rtpVideoOut(packet, app);
+
+    return GST_FLOW_OK;
+}
+
+void RtpWorker::recvrtpbin_pad_added(GstElement *element, GstPad *pad)
+{
+    Q_UNUSED(element);
+
+    gchar      *name = gst_pad_get_name(pad);
+    GstElement *dec  = nullptr;
+    guint       ssrc = 0;
+    bool        mix  = false;
+    if (g_str_has_prefix(name, "recv_rtp_src_0_")) {
+        dec = audiodecbin;
+        // recv_rtp_src_<session>_<ssrc>_<pt>
+        mix = audiomixer && sscanf(name, "recv_rtp_src_0_%u_", &ssrc) == 1;
+    } else if (g_str_has_prefix(name, "recv_rtp_src_1_"))
+        dec = videodecbin;
+#ifdef RTPWORKER_DEBUG
+    qDebug("rtpbin pad-added: %s", name);
+#endif
+    g_free(name);
+
+    if (mix) {
+        addParticipant(pad, ssrc);
+        return;
+    }
+
+    if (!dec)
+        return;
+
+    // one pad shows up per remote ssrc. if the peer restarts its stream
+    //   under a new ssrc, the newest one takes over the decoder
+    GstPad *sinkpad = gst_element_get_static_pad(dec, "sink");
+    GstPad *old     = gst_pad_get_peer(sinkpad);
+    if (old) {
+        gst_pad_unlink(old, sinkpad);
+        gst_object_unref(old);
+    }
+    gst_pad_link(pad, sinkpad);
+    gst_object_unref(sinkpad);
+
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, dec == audiodecbin ? cb_sync_audio : cb_sync_video, this,
+                      nullptr);
+}
+
+// conference mode: each remote ssrc gets a decoder and volume of its own,
+//   linked to a new mixer pad. a known ssrc (e.g. after a payload type
+//   change) takes over its old decoder. this runs on rtpbin's streaming
+//   threads, so participants_mutex is only held to look the ssrc up and
+//   to store it, not while the elements are built and started
+void RtpWorker::addParticipant(GstPad *pad, quint32 ssrc)
+{
+    GstElement *bin;
+    GstElement *mixer;
+    GstElement *decoder = nullptr;
+    {
+        QMutexLocker locker(&participants_mutex);
+        if (!recvbin || !audiomixer)
+            return;
+
+        bin   = GST_ELEMENT(gst_object_ref(recvbin));
+        mixer = GST_ELEMENT(gst_object_ref(audiomixer));
+
+        auto it = participants.constFind(ssrc);
+        if (it != participants.constEnd())
+            decoder = GST_ELEMENT(gst_object_ref(it->decoder));
+    }
+
+    if (!decoder) {
+        Participant p;
+        p.decoder = BinPool::instance()->audiodec(recvAudioCodec, opusOptions);
+        p.volume  = p.decoder ? gst_element_factory_make("volume", nullptr) : nullptr;
+        if (!p.volume) {
+            if (p.decoder) {
+                gst_element_set_state(p.decoder, GST_STATE_NULL);
+                gst_object_ref_sink(p.decoder);
+                gst_object_unref(p.decoder);
+            }
+            gst_object_unref(mixer);
+            gst_object_unref(bin);
+            return;
+        }
+
+        // decoder bins always come with the same name
+        gchar *decname = g_strdup_printf("audiodecbin_%08x", ssrc);
+        gst_object_set_name(GST_OBJECT(p.decoder), decname);
+        g_free(decname);
+
+        // set before it's linked, so a muted participant isn't heard at
+        //   all. it's set again once stored, in case it changed meanwhile
+        {
+            QMutexLocker locker(&participants_mutex);
+            applyParticipantVolume(ssrc, p);
+        }
+
+        gst_bin_add_many(GST_BIN(bin), p.decoder, p.volume, nullptr);
+        gst_element_link(p.decoder, p.volume);
+        gst_element_link_pads(p.volume, "src", mixer, "sink_%u");
+        gst_element_sync_state_with_parent(p.volume);
+        gst_element_sync_state_with_parent(p.decoder);
+
+        // the receive branch may have gone, or another thread may have
+        //   added the same ssrc in the meantime
+        bool stored = false;
+        {
+            QMutexLocker locker(&participants_mutex);
+            if (audiomixer == mixer && !participants.contains(ssrc)) {
+                participants.insert(ssrc, p);
+                applyParticipantVolume(ssrc, p);
+                stored = true;
+#ifdef RTPWORKER_DEBUG
+                qDebug("conference: participant %08x joined (%d total)", ssrc, int(participants.size()));
+#endif
+            }
+        }
+
+        if (stored)
+            decoder = GST_ELEMENT(gst_object_ref(p.decoder));
+        else
+            dropParticipant(p, bin, mixer);
+    }
+
+    if (decoder) {
+        GstPad *sinkpad = gst_element_get_static_pad(decoder, "sink");
+        GstPad *old     = gst_pad_get_peer(sinkpad);
+        if (old) {
+            gst_pad_unlink(old, sinkpad);
+            gst_object_unref(old);
+        }
+        gst_pad_link(pad, sinkpad);
+        gst_object_unref(sinkpad);
+        gst_object_unref(decoder);
+    }
+
+    gst_object_unref(mixer);
+    gst_object_unref(bin);
+}
+
+// unlinks a participant from rtpbin and the mixer, and drops its elements
+void RtpWorker::dropParticipant(const Participant &p, GstElement *bin, GstElement *mixer)
+{
+    GstPad *sinkpad = gst_element_get_static_pad(p.decoder, "sink");
+    GstPad *rtppad  = gst_pad_get_peer(sinkpad);
+    if (rtppad) {
+        gst_pad_unlink(rtppad, sinkpad);
+        gst_object_unref(rtppad);
+    }
+    gst_object_unref(sinkpad);
+
+    GstPad *srcpad = gst_element_get_static_pad(p.volume, "src");
+    GstPad *mixpad = gst_pad_get_peer(srcpad);
+    if (mixpad) {
+        gst_pad_unlink(srcpad, mixpad);
+        gst_element_release_request_pad(mixer, mixpad);
+        gst_object_unref(mixpad);
+    }
+    gst_object_unref(srcpad);
+
+    gst_element_set_state(p.decoder, GST_STATE_NULL);
+    gst_element_set_state(p.volume, GST_STATE_NULL);
+    gst_bin_remove_many(GST_BIN(bin), p.decoder, p.volume, nullptr);
+}
+
+// called from rtpbin's threads when an ssrc sends a bye or times out. the
+//   elements can't be torn down from there, so that's left to our own
+//   thread
+void RtpWorker::participantLeft(quint32 ssrc)
+{
+    QMutexLocker locker(&participants_mutex);
+    if (!participants.contains(ssrc))
+        return;
+
+    leftParticipants += ssrc;
+    if (!participantsTimer) {
+        participantsTimer = g_timeout_source_new(0);
+        g_source_set_callback(participantsTimer, cb_removeParticipants, this, nullptr);
+        g_source_attach(participantsTimer, mainContext_);
+    }
+}
+
+// drops each participant that left. should the ssrc come back, it's
+//   added anew
+gboolean RtpWorker::removeParticipants()
+{
+    QList<Participant> gone;
+    GstElement        *mixer;
+    {
+        QMutexLocker locker(&participants_mutex);
+        g_source_unref(participantsTimer);
+        participantsTimer = nullptr;
+        mixer             = audiomixer;
+
+        for (quint32 ssrc : std::as_const(leftParticipants)) {
+            auto it = participants.find(ssrc);
+            if (it == participants.end())
+                continue;
+            gone += it.value();
+            participants.erase(it);
+#ifdef RTPWORKER_DEBUG
+            qDebug("conference: participant %08x left (%d total)", ssrc, int(participants.size()));
+#endif
+        }
+        leftParticipants.clear();
+    }
+
+    for (const Participant &p : std::as_const(gone))
+        dropParticipant(p, recvbin, mixer);
+
+    return FALSE;
+}
+
+// the payload maps are whatever the rtp appsrcs were configured with
+GstCaps *RtpWorker::recvrtpbin_request_pt_map(guint session, guint pt)
+{
+    GstElement *src  = session == 0 ? audiortpsrc : videortpsrc;
+    GstCaps    *caps = nullptr;
+    if (src)
+        g_object_get(G_OBJECT(src), "caps", &caps, nullptr);
+
+    if (caps) {
+        GstStructure *cs = gst_caps_get_structure(caps, 0);
+        int           id = -1;
+        if (!gst_structure_get_int(cs, "payload", &id) || id != int(pt)) {
+            gst_caps_unref(caps);
+            caps = nullptr;
+        }
+    }
+
+    return caps;
+}
+
+GstElement *RtpWorker::ensureSendRtpBin()
+{
+    if (sendrtpbin)
+        return sendrtpbin;
+
+    sendrtpbin = bins_rtpbin_create("sendrtpbin");
+    if (!sendrtpbin)
+        return nullptr;
+
+    gst_bin_add(GST_BIN(sendbin), sendrtpbin);
+    gst_element_sync_state_with_parent(sendrtpbin);
+    return sendrtpbin;
+}
+
+// outgoing rtcp of the session is handed to the app like rtp, and if
+//   rtcpsrc is given it receives the remote side's rtcp
+void RtpWorker::addRtcpChain(GstElement *bin, GstElement *rtpbin, int session, GstElement **rtcpsrc)
+{
+    GstElement *rtcpsink    = gst_element_factory_make("appsink", nullptr);
+    auto        appRtcpSink = GST_APP_SINK(rtcpsink);
+    g_object_set(G_OBJECT(appRtcpSink), "sync", FALSE, "async", FALSE, nullptr);
+
+    GstAppSinkCallbacks sinkCb;
+    sinkCb.new_sample  = session == 0 ? cb_packet_ready_rtcp_audio : cb_packet_ready_rtcp_video;
+    sinkCb.eos         = cb_packet_ready_eos_stub;
+    sinkCb.new_preroll = cb_packet_ready_preroll_stub;
+#if GST_CHECK_VERSION(1, 22, 0)
+    sinkCb.new_event = cb_packet_ready_event_stub;
+#endif
+#if GST_CHECK_VERSION(1, 24, 0)
+    sinkCb.propose_allocation = cb_packet_ready_allocation_stub;
+#endif
+    gst_app_sink_set_callbacks(appRtcpSink, &sinkCb, this, nullptr);
+
+    QList<GstElement *> &branch = (bin == sendbin ? sendBranch : recvBranch)[session];
+
+    gst_bin_add(GST_BIN(bin), rtcpsink);
+    branch += rtcpsink;
+    QByteArray srcName = "send_rtcp_src_" + QByteArray::number(session);
+    gst_element_link_pads(rtpbin, srcName.data(), rtcpsink, "sink");
+    gst_element_sync_state_with_parent(rtcpsink);
+
+    if (!rtcpsrc)
+        return;
+
+    GstElement *src  = gst_element_factory_make("appsrc", nullptr);
+    GstCaps    *caps = gst_caps_new_empty_simple("application/x-rtcp");
+    g_object_set(G_OBJECT(src), "caps", caps, nullptr);
+    gst_caps_unref(caps);
+
+    gst_bin_add(GST_BIN(bin), src);
+    branch += src;
+    QByteArray sinkName = "recv_rtcp_sink_" + QByteArray::number(session);
+    gst_element_link_pads(src, "src", rtpbin, sinkName.data());
+    gst_element_sync_state_with_parent(src);
+
+    *rtcpsrc = src;
+}
+
+void RtpWorker::startStatsTimer()
+{
+    if (statsTimer)
+        return;
+
+    statsTimer = g_timeout_source_new(STATS_INTERVAL);
+    g_source_set_callback(statsTimer, cb_statsTimeout, this, nullptr);
+    g_source_attach(statsTimer, mainContext_);
+}
+
+// calls func with the stats structure of each source in the session
+template <typename F> static void forEachRtpSource(GstElement *rtpbin, guint session, F func)
+{
+    GObject *rtpsession = nullptr;
+    g_signal_emit_by_name(rtpbin, "get-internal-session", session, &rtpsession);
+    if (!rtpsession)
+        return;
+
+    GstStructure *stats = nullptr;
+    g_object_get(rtpsession, "stats", &stats, nullptr);
+    g_object_unref(rtpsession);
+    if (!stats)
+        return;
+
+    const GValue *value = gst_structure_get_value(stats, "source-stats");
+    if (value && G_VALUE_HOLDS(value, G_TYPE_VALUE_ARRAY)) {
+        G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+        auto sources = static_cast<GValueArray *>(g_value_get_boxed(value));
+        for (guint n = 0; sources && n < sources->n_values; ++n)
+            func(gst_value_get_structure(g_value_array_get_nth(sources, n)));
+        G_GNUC_END_IGNORE_DEPRECATIONS
+    }
+    gst_structure_free(stats);
+}
+
+static int rtpTimeToMs(guint value, int clockRate)
+{
+    if (clockRate <= 0)
+        return -1;
+    return int(quint64(value) * 1000 / quint64(clockRate));
+}
+
+// our own stream, plus what the remote side reported about it
+static void readSendStats(GstElement *rtpbin, guint session, PRtpStreamStats *out)
+{
+    int clockRate = session == 0 ? 48000 : 90000;
+    forEachRtpSource(rtpbin, session, [&](const GstStructure *s) {
+        gboolean internal = FALSE, sender = FALSE;
+        gst_structure_get_boolean(s, "internal", &internal);
+        gst_structure_get_boolean(s, "is-sender", &sender);
+        if (!internal || !sender)
+            return;
+
+        guint   ssrc = 0;
+        guint64 sent = 0;
+        gst_structure_get_uint(s, "ssrc", &ssrc);
+        gst_structure_get_uint64(s, "packets-sent", &sent);
+        gst_structure_get_int(s, "clock-rate", &clockRate);
+        out->ssrc    = ssrc;
+        out->packets = sent;
+    });
+
+    // report blocks are kept on the source that sent them
+    forEachRtpSource(rtpbin, session, [&](const GstStructure *s) {
+        gboolean internal = TRUE, haveRb = FALSE;
+        gst_structure_get_boolean(s, "internal", &internal);
+        gst_structure_get_boolean(s, "have-rb", &haveRb);
+        if (internal || !haveRb)
+            return;
+
+        guint rbSsrc = 0;
+        if (gst_structure_get_uint(s, "rb-ssrc", &rbSsrc) && out->ssrc && rbSsrc != out->ssrc)
+            return;
+
+        guint fraction = 0, jitter = 0, rtt = 0;
+        int   lost     = 0;
+        gst_structure_get_uint(s, "rb-fractionlost", &fraction);
+        gst_structure_get_int(s, "rb-packetslost", &lost);
+        gst_structure_get_uint(s, "rb-jitter", &jitter);
+        gst_structure_get_uint(s, "rb-round-trip", &rtt);
+        out->packetsLost  = lost;
+        out->fractionLost = double(fraction) / 256;
+        out->jitter       = rtpTimeToMs(jitter, clockRate);
+        if (rtt > 0)
+            out->roundTripTime = int(quint64(rtt) * 1000 / 65536); // 16.16 fixed point seconds
+    });
+}
+
+// the remote stream as seen by our jitterbuffer
+static void readRecvStats(GstElement *rtpbin, guint session, PRtpStreamStats *out)
+{
+    forEachRtpSource(rtpbin, session, [&](const GstStructure *s) {
+        gboolean internal = TRUE, sender = FALSE;
+        gst_structure_get_boolean(s, "internal", &internal);
+        gst_structure_get_boolean(s, "is-sender", &sender);
+        if (internal || !sender)
+            return;
+
+        guint   ssrc = 0, jitter = 0;
+        guint64 received  = 0;
+        int     lost      = 0;
+        int     clockRate = session == 0 ? 48000 : 90000;
+        gst_structure_get_uint(s, "ssrc", &ssrc);
+        gst_structure_get_uint64(s, "packets-received", &received);
+        gst_structure_get_int(s, "packets-lost", &lost);
+        gst_structure_get_uint(s, "jitter", &jitter);
+        gst_structure_get_int(s, "clock-rate", &clockRate);
+
+        // more than one sender only happens after an ssrc change, and
+        //   the busiest one is the one we're playing
+        if (received < out->packets)
+            return;
+
+        out->ssrc        = ssrc;
+        out->packets     = received;
+        out->packetsLost = lost;
+        out->jitter      = rtpTimeToMs(jitter, clockRate);
+    });
+}
+
+static void updateFractionLost(PRtpStreamStats *stats, quint64 *lastPackets, qint64 *lastLost)
+{
+    // counters went backwards, the stream was replaced
+    if (stats->packets < *lastPackets) {
+        *lastPackets = 0;
+        *lastLost    = 0;
+    }
+
+    quint64 packets = stats->packets - *lastPackets;
+    qint64  lost    = stats->packetsLost - *lastLost;
+    if (lost > 0)
+        stats->fractionLost = double(lost) / double(packets + quint64(lost));
+    else
+        stats->fractionLost = 0;
+
+    *lastPackets = stats->packets;
+    *lastLost    = stats->packetsLost;
+}
+
+// executed in the streaming threads. pads of an ssrc that was taken over
+//   still push (into nothing) and are ignored
+void RtpWorker::updateSyncPoint(int session, GstPad *pad, GstBuffer *buffer)
+{
+    guchar header[8];
+    if (!GST_BUFFER_PTS_IS_VALID(buffer) || !gst_pad_is_linked(pad)
+        || gst_buffer_extract(buffer, 4, header, sizeof(header)) != sizeof(header))
+        return;
+
+    QMutexLocker locker(&sync_mutex);
+    SyncPoint   &p = syncPoints[session];
+    p.rtptime      = (quint32(header[0]) << 24) | (quint32(header[1]) << 16) | (quint32(header[2]) << 8) | header[3];
+    p.ssrc         = (quint32(header[4]) << 24) | (quint32(header[5]) << 16) | (quint32(header[6]) << 8) | header[7];
+    p.pts          = GST_BUFFER_PTS(buffer);
+}
+
+// executed in the streaming threads, for decoded buffers on their way
+//   into playback
+void RtpWorker::updatePlayPoint(int session, GstPad *pad, GstBuffer *buffer)
+{
+    if (!GST_BUFFER_PTS_IS_VALID(buffer))
+        return;
+
+    GstElement *element = gst_pad_get_parent_element(pad);
+    if (!element)
+        return;
+    GstClock *clock = gst_element_get_clock(element);
+    GstEvent *event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    if (clock && event) {
+        const GstSegment *segment = nullptr;
+        gst_event_parse_segment(event, &segment);
+        GstClockTime running = gst_segment_to_running_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+        GstClockTime now     = gst_clock_get_time(clock) - gst_element_get_base_time(element);
+        if (GST_CLOCK_TIME_IS_VALID(running)) {
+            QMutexLocker locker(&sync_mutex);
+            syncPoints[session].arrival = GST_CLOCK_DIFF(running, now);
+        }
+    }
+    if (event)
+        gst_event_unref(event);
+    if (clock)
+        gst_object_unref(clock);
+    gst_object_unref(element);
+}
+
+void RtpWorker::resetSyncPoint(int session)
+{
+    QMutexLocker locker(&sync_mutex);
+    syncPoints[session] = SyncPoint();
+}
+
+// rtpbin lines up the jitterbuffers of streams with the same cname using
+//   the sender reports, so this only checks how well that worked. the
+//   sender's ntp time of the last rtp timestamp out of the jitterbuffer
+//   is set against its pts, for each media. both sinks play a buffer at
+//   its running time plus the pipeline latency, unless decoding and
+//   conversion got it to them later than that, in which case it plays as
+//   soon as it arrives. that lateness is added, so the difference between
+//   the two is the offset the user sees. positive means video is late
+bool RtpWorker::avOffset(int *ms)
+{
+    SyncPoint points[2];
+    sync_mutex.lock();
+    points[0] = syncPoints[0];
+    points[1] = syncPoints[1];
+    sync_mutex.unlock();
+
+    GstClockTime latency = 0;
+    GstQuery    *query   = gst_query_new_latency();
+    if (gst_element_query(rpipeline, query))
+        gst_query_parse_latency(query, nullptr, &latency, nullptr);
+    gst_query_unref(query);
+
+    qint64 skew[2];
+    for (int session = 0; session < 2; ++session) {
+        const SyncPoint &p = points[session];
+        if (!GST_CLOCK_TIME_IS_VALID(p.pts))
+            return false;
+        qint64 late = qMax(p.arrival - GstClockTimeDiff(latency), GstClockTimeDiff(0));
+
+        bool found = false;
+        forEachRtpSource(recvrtpbin, guint(session), [&](const GstStructure *s) {
+            gboolean internal = TRUE, haveSr = FALSE;
+            gst_structure_get_boolean(s, "internal", &internal);
+            gst_structure_get_boolean(s, "have-sr", &haveSr);
+            if (internal || !haveSr)
+                return;
+
+            guint   ssrc = 0, srRtpTime = 0;
+            guint64 srNtpTime = 0;
+            int     clockRate = -1;
+            gst_structure_get_uint(s, "ssrc", &ssrc);
+            gst_structure_get_uint64(s, "sr-ntptime", &srNtpTime);
+            gst_structure_get_uint(s, "sr-rtptime", &srRtpTime);
+            gst_structure_get_int(s, "clock-rate", &clockRate);
+            if (ssrc != p.ssrc || clockRate <= 0)
+                return;
+
+            // ntp is 32.32 fixed point seconds
+            qint64 ntp  = qint64(gst_util_uint64_scale(srNtpTime, GST_SECOND, G_GUINT64_CONSTANT(1) << 32));
+            qint64 diff = qint64(qint32(p.rtptime - srRtpTime)) * qint64(GST_SECOND) / clockRate;
+
+            skew[session] = qint64(p.pts) - (ntp + diff) + late;
+            found         = true;
+        });
+        if (!found)
+            return false;
+    }
+
+    *ms = int((skew[1] - skew[0]) / qint64(GST_MSECOND));
+    return true;
+}
+
+gboolean RtpWorker::statsTimeout()
+{
+    PRtpSessionStats stats;
+    if (sendrtpbin) {
+        readSendStats(sendrtpbin, 0, &stats.audioOut);
+        readSendStats(sendrtpbin, 1, &stats.videoOut);
+    }
+    if (recvrtpbin) {
+        readRecvStats(recvrtpbin, 0, &stats.audioIn);
+        readRecvStats(recvrtpbin, 1, &stats.videoIn);
+        updateFractionLost(&stats.audioIn, &audioInLastPackets, &audioInLastLost);
+        updateFractionLost(&stats.videoIn, &videoInLastPackets, &videoInLastLost);
+        stats.haveAvOffset = avOffset(&stats.avOffset);
+    }
+
+    stats.timeToStarted = timeToStarted;
+
+    if (pd_audiosrc)
+        stats.audioOut.deviceSwitchGlitch = pd_audiosrc->lastSwitchGlitch();
+    if (pd_videosrc)
+        stats.videoOut.deviceSwitchGlitch = pd_videosrc->lastSwitchGlitch();
+    if (pd_audiosink)
+        stats.audioIn.deviceSwitchGlitch = pd_audiosink->lastSwitchGlitch();
+
+    if (cb_statistics)
+        cb_statistics(stats, app);
+    return TRUE;
+}
+
+gboolean RtpWorker::fileReady()
+{
+    if (loopFile) {
         // gst_element_set_state(sendPipeline, GST_STATE_PAUSED);
         // gst_element_get_state(sendPipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
 
@@ -882,83 +2051,535 @@ gboolean RtpWorker::fileReady()
     // gst_element_set_state(sendPipeline, GST_STATE_PLAYING);
     // gst_element_get_state(sendPipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
 
-    if (!getCaps()) {
-        error = RtpSessionContext::ErrorCodec;
-        if (cb_error)
-            cb_error(app);
-        return FALSE;
+    if (!getCaps()) {
+        error = RtpSessionContext::ErrorCodec;
+        if (cb_error)
+            cb_error(app);
+        return FALSE;
+    }
+
+    signalStarted();
+    return FALSE;
+}
+
+void RtpWorker::signalStarted()
+{
+    timeToStarted = int((PRtpPacket::currentTime() - startRequested) / 1000);
+#ifdef RTPWORKER_DEBUG
+    BinPool::Stats pool = BinPool::instance()->stats();
+    qDebug("started in %d ms, bin pool: %llu hits/%llu misses", timeToStarted, pool.hits, pool.misses);
+#endif
+    if (cb_started)
+        cb_started(app);
+}
+
+// releases the request pads of one rtpbin session, which also takes down
+//   its internal elements
+static void releaseRtpSession(GstElement *rtpbin, int session)
+{
+    static const char *names[] = { "send_rtp_sink_%d", "recv_rtp_sink_%d", "send_rtcp_src_%d", "recv_rtcp_sink_%d" };
+    for (const char *fmt : names) {
+        gchar  *name = g_strdup_printf(fmt, session);
+        GstPad *pad  = gst_element_get_static_pad(rtpbin, name);
+        g_free(name);
+        if (pad) {
+            gst_element_release_request_pad(rtpbin, pad);
+            gst_object_unref(pad);
+        }
+    }
+}
+
+// the payload info a payloader settled on, once it has negotiated caps
+static bool payloaderInfo(GstElement *pay, PPayloadInfo *pi)
+{
+    GstPad  *pad  = gst_element_get_static_pad(pay, "src");
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    gst_object_unref(pad);
+    if (!caps)
+        return false;
+
+    *pi = structureToPayloadInfo(gst_caps_get_structure(caps, 0));
+    gst_caps_unref(caps);
+    return pi->id != -1;
+}
+
+gboolean RtpWorker::capsTimeout()
+{
+    PPayloadInfo audioInfo, videoInfo;
+    bool         audioReady = !pendingCaps[0] || payloaderInfo(audiortppay, &audioInfo);
+    bool         videoReady = !pendingCaps[1] || payloaderInfo(videortppay, &videoInfo);
+    if ((!audioReady || !videoReady) && --capsWaitLeft > 0)
+        return TRUE;
+
+    g_source_unref(capsTimer);
+    capsTimer = nullptr;
+
+    if (!audioReady || !videoReady) {
+#ifdef RTPWORKER_DEBUG
+        qDebug("new send branch never negotiated");
+#endif
+        pendingCaps[0] = false;
+        pendingCaps[1] = false;
+        error          = RtpSessionContext::ErrorCodec;
+        if (cb_error)
+            cb_error(app);
+        return FALSE;
+    }
+
+    if (pendingCaps[0]) {
+        actual_localAudioPayloadInfo = QList<PPayloadInfo>() << audioInfo;
+        localAudioPayloadInfo        = actual_localAudioPayloadInfo;
+        canTransmitAudio             = true;
+        pendingCaps[0]               = false;
+    }
+    if (pendingCaps[1]) {
+        actual_localVideoPayloadInfo = QList<PPayloadInfo>() << videoInfo;
+        localVideoPayloadInfo        = actual_localVideoPayloadInfo;
+        canTransmitVideo             = true;
+        pendingCaps[1]               = false;
+    }
+
+    if (cb_updated)
+        cb_updated(app);
+    return FALSE;
+}
+
+bool RtpWorker::setupSendRecv()
+{
+    // FIXME:
+    // this code is not really correct, but it will suffice for our
+    //   modest purposes.  basically the way it works is:
+    //   - non-empty params indicate desire for a media type
+    //   - the only control you have over quality is maxbitrate
+    //   - input device/file indicates desire to send
+    //   - remote payloadinfo indicates desire to receive (we need this
+    //     to support vp8)
+    //   - once sending or receiving is started, audio and video can
+    //     be added or removed on the send side (device input only) and
+    //     on the receive side. see updateSendMedia/updateRecvMedia
+    //   - once sending or receiving is started, codecs can't be changed
+    //     (changes will be rejected).  one exception: remote  vp8
+    //     config can be updated.
+    //   - once sending or receiving is started, devices are switched in
+    //     place by switchDevices() rather than here
+    //   - while held, nothing that needs a device is started. resume()
+    //     comes back through here
+
+    if (!sendbin) {
+        if (!held && (!localAudioParams.isEmpty() || !localVideoParams.isEmpty())) {
+            if (!startSend())
+                return false;
+        }
+    } else if (!fileDemux) {
+        if (!updateSendMedia())
+            return false;
+    }
+
+    if (!recvbin) {
+        if (!held
+            && ((!localAudioParams.isEmpty() && !remoteAudioPayloadInfo.isEmpty())
+                || (!localVideoParams.isEmpty() && !remoteVideoPayloadInfo.isEmpty()))) {
+            if (!startRecv())
+                return false;
+        }
+    } else {
+        if (!updateRecvMedia())
+            return false;
+
+        // see if vp8 was updated in the remote config
+        updateVp8Config();
+    }
+
+    // apply actual settings back to these variables, so the user can
+    //   read them
+    localAudioPayloadInfo  = actual_localAudioPayloadInfo;
+    localVideoPayloadInfo  = actual_localVideoPayloadInfo;
+    remoteAudioPayloadInfo = actual_remoteAudioPayloadInfo;
+    remoteVideoPayloadInfo = actual_remoteVideoPayloadInfo;
+
+    if (sendbin || recvbin)
+        startStatsTimer();
+
+    return true;
+}
+
+// adds or removes the audio and video branches of a running sendbin to
+//   match the local params. the other media keeps flowing throughout
+bool RtpWorker::updateSendMedia()
+{
+    bool wantAudio = !ain.isEmpty() && !localAudioParams.isEmpty();
+    bool wantVideo = !vin.isEmpty() && !localVideoParams.isEmpty();
+
+    if (audiortppay && !wantAudio)
+        removeSendBranch(0);
+    if (videortppay && !wantVideo)
+        removeSendBranch(1);
+
+    // a new branch needs its device, so it has to wait for resume()
+    if (held)
+        return true;
+
+    if (!audiortppay && wantAudio) {
+        if (!addSendBranch(0))
+            return false;
+        pendingCaps[0] = true;
+    }
+    if (!videortppay && wantVideo) {
+        if (!addSendBranch(1))
+            return false;
+        pendingCaps[1] = true;
+    }
+
+    // the payload info of new branches is only known once media went
+    //   through them, so hold off on reporting the update until then
+    if ((pendingCaps[0] || pendingCaps[1]) && !capsTimer) {
+        capsWaitLeft = CAPS_WAIT_MAX / CAPS_WAIT_INTERVAL;
+        capsTimer    = g_timeout_source_new(CAPS_WAIT_INTERVAL);
+        g_source_set_callback(capsTimer, cb_capsTimeout, this, nullptr);
+        g_source_attach(capsTimer, mainContext_);
+    }
+
+    return true;
+}
+
+bool RtpWorker::addSendBranch(int session)
+{
+    bool audio = session == 0;
+
+    PipelineDeviceOptions opts;
+    if (audio) {
+        if (pd_audiosink) {
+            opts     = pd_audiosink->options();
+            opts.aec = !opts.echoProberName.isEmpty();
+        }
+    } else {
+        opts.videoSize = localVideoParams[0].size;
+        opts.fps       = 30;
+    }
+
+    PDevice::Type          type = audio ? PDevice::AudioIn : PDevice::VideoIn;
+    PipelineDeviceContext *pd
+        = PipelineDeviceContext::create(send_pipelineContext, audio ? ain : vin, type, hardwareDeviceMonitor_, opts);
+    if (!pd) {
+#ifdef RTPWORKER_DEBUG
+        qDebug("Failed to create %s input element", audio ? "audio" : "video");
+#endif
+        error = RtpSessionContext::ErrorGeneric;
+        return false;
+    }
+
+    GstElement *src = pd->element();
+    if (audio) {
+        pd_audiosrc = pd;
+        audiosrc    = src;
+    } else {
+        pd_videosrc = pd;
+        videosrc    = src;
+    }
+
+    if (!(audio ? addAudioChain() : addVideoChain())) {
+        delete pd;
+        if (audio) {
+            pd_audiosrc = nullptr;
+            audiosrc    = nullptr;
+        } else {
+            pd_videosrc = nullptr;
+            videosrc    = nullptr;
+        }
+        error = RtpSessionContext::ErrorGeneric;
+        return false;
+    }
+
+    // a pad added to a running bin has to be activated by hand
+    const char *ghostName = audio ? "sink0" : "sink1";
+    GstPad     *ghost     = gst_element_get_static_pad(sendbin, ghostName);
+    gst_pad_set_active(ghost, TRUE);
+    gst_object_unref(ghost);
+    gst_element_link_pads(src, "src", sendbin, ghostName);
+
+    // start from the rtp end, so nothing is pushed into elements that
+    //   aren't running yet. the device comes last
+    for (int n = int(sendBranch[session].count()) - 1; n >= 0; --n)
+        gst_element_sync_state_with_parent(sendBranch[session][n]);
+    gst_element_sync_state_with_parent(src);
+
+#ifdef RTPWORKER_DEBUG
+    qDebug("%s send branch added", audio ? "audio" : "video");
+#endif
+    return true;
+}
+
+// same as PipelineDevice::update(): the device side is blocked while the
+//   branch is taken apart, so nothing is in flight
+void RtpWorker::removeSendBranch(int session)
+{
+    bool audio = session == 0;
+
+    GstElement *src     = audio ? audiosrc : videosrc;
+    GstPad     *srcpad  = src ? gst_element_get_static_pad(src, "src") : nullptr;
+    gulong      probeId = 0;
+    if (srcpad) {
+        probeId      = pipeline_blockPadWhenIdle(srcpad);
+        GstPad *peer = gst_pad_get_peer(srcpad);
+        if (peer) {
+            gst_pad_unlink(srcpad, peer);
+            gst_object_unref(peer);
+        }
+    }
+
+    if (audio) {
+        QMutexLocker locker(&volumein_mutex);
+        volumein = nullptr;
+    }
+    if (audio) {
+        QMutexLocker locker(&rtpaudioout_mutex);
+        audiovalve = nullptr;
+    } else {
+        QMutexLocker locker(&rtpvideoout_mutex);
+        videovalve = nullptr;
+    }
+    removeBranch(sendbin, sendrtpbin, session);
+
+    GstPad *ghost = gst_element_get_static_pad(sendbin, audio ? "sink0" : "sink1");
+    if (ghost) {
+        gst_pad_set_active(ghost, FALSE);
+        gst_element_remove_pad(sendbin, ghost);
+        gst_object_unref(ghost);
+    }
+
+    // the device goes to NULL with its context, which also lets go of
+    //   the blocked pad
+    if (audio) {
+        delete pd_audiosrc;
+        pd_audiosrc       = nullptr;
+        audiosrc          = nullptr;
+        audiortppay       = nullptr;
+        audiortcpsrc_send = nullptr;
+        canTransmitAudio  = false;
+        pendingCaps[0]    = false;
+        actual_localAudioPayloadInfo.clear();
+    } else {
+        delete pd_videosrc;
+        pd_videosrc       = nullptr;
+        videosrc          = nullptr;
+        videortppay       = nullptr;
+        videortcpsrc_send = nullptr;
+        canTransmitVideo  = false;
+        pendingCaps[1]    = false;
+        actual_localVideoPayloadInfo.clear();
+    }
+
+    if (srcpad) {
+        gst_pad_remove_probe(srcpad, probeId);
+        gst_object_unref(srcpad);
+    }
+
+#ifdef RTPWORKER_DEBUG
+    qDebug("%s send branch removed", audio ? "audio" : "video");
+#endif
+}
+
+// adds or removes the audio and video branches of a running recvbin to
+//   match the remote payload info. the other media keeps flowing
+//   throughout
+bool RtpWorker::updateRecvMedia()
+{
+    bool wantAudio = !remoteAudioPayloadInfo.isEmpty();
+    bool wantVideo = !remoteVideoPayloadInfo.isEmpty();
+
+    if (audiortpsrc && !wantAudio)
+        removeRecvAudioChain();
+    if (videortpsrc && !wantVideo)
+        removeRecvVideoChain();
+
+    // a new audio branch may need its device, so it has to wait for
+    //   resume()
+    if (!audiortpsrc && wantAudio && !held) {
+        if (!addRecvAudioChain()) {
+            error = RtpSessionContext::ErrorCodec;
+            return false;
+        }
+
+        // a pad added to a running bin has to be activated by hand
+        GstPad *ghost = gst_element_get_static_pad(recvbin, "src");
+        if (ghost) {
+            gst_pad_set_active(ghost, TRUE);
+            gst_object_unref(ghost);
+            gst_element_link(recvbin, pd_audiosink->element());
+        }
+
+        // start from the output, so nothing is pushed into elements that
+        //   aren't running yet
+        if (pd_audiosink)
+            gst_element_sync_state_with_parent(pd_audiosink->element());
+        for (int n = int(recvBranch[0].count()) - 1; n >= 0; --n)
+            gst_element_sync_state_with_parent(recvBranch[0][n]);
+
+#ifdef RTPWORKER_DEBUG
+        qDebug("audio recv branch added");
+#endif
+    }
+
+    if (!videortpsrc && wantVideo) {
+        if (!addRecvVideoChain()) {
+            error = RtpSessionContext::ErrorCodec;
+            return false;
+        }
+
+        for (int n = int(recvBranch[1].count()) - 1; n >= 0; --n)
+            gst_element_sync_state_with_parent(recvBranch[1][n]);
+
+#ifdef RTPWORKER_DEBUG
+        qDebug("video recv branch added");
+#endif
+    }
+
+    return true;
+}
+
+void RtpWorker::removeRecvAudioChain()
+{
+    // nothing else feeds the appsrcs, they are only pushed from this
+    //   thread
+    audiortpsrc       = nullptr;
+    audiortcpsrc_recv = nullptr;
+    audioIngress.clear();
+
+    // and block what comes out of the rtpbin, into the decoder or, in
+    //   conference mode, into the decoders of the participants
+    QList<GstElement *> decoders;
+    if (audiodecbin)
+        decoders += audiodecbin;
+    {
+        QMutexLocker locker(&participants_mutex);
+        for (const Participant &p : std::as_const(participants)) {
+            decoders += p.decoder;
+            recvBranch[0] << p.decoder << p.volume;
+        }
+        participants.clear();
+        leftParticipants.clear();
+        audiomixer = nullptr;
+    }
+
+    QList<QPair<GstPad *, gulong>> blocked;
+    for (GstElement *dec : std::as_const(decoders)) {
+        GstPad *sinkpad = gst_element_get_static_pad(dec, "sink");
+        GstPad *peer    = gst_pad_get_peer(sinkpad);
+        if (peer) {
+            blocked += qMakePair(peer, pipeline_blockPadWhenIdle(peer));
+            gst_pad_unlink(peer, sinkpad);
+        }
+        gst_object_unref(sinkpad);
+    }
+    audiodecbin = nullptr;
+    resetSyncPoint(0);
+
+    {
+        QMutexLocker locker(&volumeout_mutex);
+        volumeout = nullptr;
+    }
+
+    removeBranch(recvbin, recvrtpbin, 0);
+
+    for (const auto &b : std::as_const(blocked)) {
+        gst_pad_remove_probe(b.first, b.second);
+        gst_object_unref(b.first);
+    }
+
+    // the device goes to NULL with its context
+    GstPad *ghost = gst_element_get_static_pad(recvbin, "src");
+    if (ghost) {
+        gst_pad_set_active(ghost, FALSE);
+        gst_element_remove_pad(recvbin, ghost);
+        gst_object_unref(ghost);
+    }
+    if (pd_audiosink) {
+        delete pd_audiosink;
+        pd_audiosink = nullptr;
+
+        if (pd_audiosrc) {
+            PipelineDeviceOptions opts = pd_audiosrc->options();
+            opts.aec                   = false;
+            opts.echoProberName.clear();
+            pd_audiosrc->setOptions(opts);
+        }
+
+        // the output may have been the clock of the pipeline
+        if (!(shared_clock && send_clock_is_shared))
+            replaceClock(rpipeline);
     }
 
-    if (cb_started)
-        cb_started(app);
-    return FALSE;
+    actual_remoteAudioPayloadInfo.clear();
+
+#ifdef RTPWORKER_DEBUG
+    qDebug("audio recv branch removed");
+#endif
 }
 
-bool RtpWorker::setupSendRecv()
+void RtpWorker::removeRecvVideoChain()
 {
-    // FIXME:
-    // this code is not really correct, but it will suffice for our
-    //   modest purposes.  basically the way it works is:
-    //   - non-empty params indicate desire for a media type
-    //   - the only control you have over quality is maxbitrate
-    //   - input device/file indicates desire to send
-    //   - remote payloadinfo indicates desire to receive (we need this
-    //     to support vp8)
-    //   - once sending or receiving is started, media types cannot
-    //     be added or removed (doing so will throw an error)
-    //   - once sending or receiving is started, codecs can't be changed
-    //     (changes will be rejected).  one exception: remote  vp8
-    //     config can be updated.
-    //   - once sending or receiving is started, devices can't be changed
-    //     (changes will be ignored)
-
-    if (!sendbin) {
-        if (!localAudioParams.isEmpty() || !localVideoParams.isEmpty()) {
-            if (!startSend())
-                return false;
+    // nothing else feeds the appsrcs, they are only pushed from this
+    //   thread
+    videortpsrc       = nullptr;
+    videortcpsrc_recv = nullptr;
+    videoIngress.clear();
+
+    // and block what comes out of the rtpbin
+    GstPad *peer    = nullptr;
+    gulong  probeId = 0;
+    if (videodecbin) {
+        GstPad *sinkpad = gst_element_get_static_pad(videodecbin, "sink");
+        peer            = gst_pad_get_peer(sinkpad);
+        if (peer) {
+            probeId = pipeline_blockPadWhenIdle(peer);
+            gst_pad_unlink(peer, sinkpad);
         }
-    } else {
-        // TODO: support adding/removing audio/video to existing session
-        /*if((localAudioParams.isEmpty() != actual_localAudioPayloadInfo.isEmpty()) || (localVideoParams.isEmpty() !=
-        actual_videoPayloadInfo.isEmpty()))
-        {
-            error = RtpSessionContext::ErrorGeneric;
-            return false;
-        }*/
+        gst_object_unref(sinkpad);
     }
+    videodecbin = nullptr;
+    resetSyncPoint(1);
 
-    if (!recvbin) {
-        if ((!localAudioParams.isEmpty() && !remoteAudioPayloadInfo.isEmpty())
-            || (!localVideoParams.isEmpty() && !remoteVideoPayloadInfo.isEmpty())) {
-            if (!startRecv())
-                return false;
-        }
-    } else {
-        // TODO: support adding/removing audio/video to existing session
+    removeBranch(recvbin, recvrtpbin, 1);
 
-        // see if vp8 was updated in the remote config
-        updateVp8Config();
+    if (peer) {
+        gst_pad_remove_probe(peer, probeId);
+        gst_object_unref(peer);
     }
 
-    // apply actual settings back to these variables, so the user can
-    //   read them
-    localAudioPayloadInfo  = actual_localAudioPayloadInfo;
-    localVideoPayloadInfo  = actual_localVideoPayloadInfo;
-    remoteAudioPayloadInfo = actual_remoteAudioPayloadInfo;
-    remoteVideoPayloadInfo = actual_remoteVideoPayloadInfo;
+    actual_remoteVideoPayloadInfo.clear();
 
-    return true;
+#ifdef RTPWORKER_DEBUG
+    qDebug("video recv branch removed");
+#endif
+}
+
+// shuts down one media branch of a running bin and takes it out. its
+//   inputs must already be cut off
+void RtpWorker::removeBranch(GstElement *bin, GstElement *rtpbin, int session)
+{
+    QList<GstElement *> &branch = (bin == sendbin ? sendBranch : recvBranch)[session];
+
+    for (GstElement *e : std::as_const(branch))
+        gst_element_set_state(e, GST_STATE_NULL);
+
+    if (rtpbin)
+        releaseRtpSession(rtpbin, session);
+
+    for (GstElement *e : std::as_const(branch))
+        gst_bin_remove(GST_BIN(bin), e);
+    branch.clear();
 }
 
 bool RtpWorker::startSend() { return startSend(16000); }
 
 bool RtpWorker::startSend(int rate)
 {
+    // stale if an earlier attempt failed
+    sendBranch[0].clear();
+    sendBranch[1].clear();
+
     // file source
     if (!infile.isEmpty() || !indata.isEmpty()) {
-        if (send_in_use)
-            return false;
-
         sendbin = gst_bin_new("sendbin");
 
         GstElement *fileSource = gst_element_factory_make("filesrc", nullptr);
@@ -975,9 +2596,6 @@ bool RtpWorker::startSend(int rate)
     }
     // device source
     else if (!ain.isEmpty() || !vin.isEmpty()) {
-        if (send_in_use)
-            return false;
-
         sendbin = gst_bin_new("sendbin");
 
         if (!ain.isEmpty() && !localAudioParams.isEmpty()) {
@@ -1005,8 +2623,7 @@ bool RtpWorker::startSend(int rate)
         if (!vin.isEmpty() && !localVideoParams.isEmpty()) {
             PipelineDeviceOptions opts;
             opts.videoSize = localVideoParams[0].size;
-            // opts.videoSize = QSize(640, 480);
-            opts.fps = 30;
+            opts.fps       = localVideoParams[0].fps > 0 ? localVideoParams[0].fps : 30;
 
             pd_videosrc = PipelineDeviceContext::create(send_pipelineContext, vin, PDevice::VideoIn,
                                                         hardwareDeviceMonitor_, opts);
@@ -1031,8 +2648,6 @@ bool RtpWorker::startSend(int rate)
     if (!sendbin)
         return true;
 
-    send_in_use = true;
-
     if (audiosrc) {
         if (!addAudioChain(rate)) {
             delete pd_audiosrc;
@@ -1120,7 +2735,7 @@ bool RtpWorker::startSend(int rate)
             return false;
         }
 
-        if (!shared_clock && use_shared_clock) {
+        if (!shared_clock && use_shared_clock()) {
             qDebug("send clock is master");
 
             shared_clock = gst_pipeline_get_clock(GST_PIPELINE(spipeline));
@@ -1128,7 +2743,7 @@ bool RtpWorker::startSend(int rate)
             send_clock_is_shared = true;
 
             // if recv active, apply this clock to it
-            if (recv_in_use) {
+            if (recvbin) {
                 qDebug("recv pipeline slaving to send clock");
                 gst_element_set_state(rpipeline, GST_STATE_READY);
                 gst_element_get_state(rpipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
@@ -1158,305 +2773,380 @@ bool RtpWorker::startSend(int rate)
     return true;
 }
 
-bool RtpWorker::startRecv()
+// the remote list is in order of preference, the first one we have a
+//   codec for is used. -1 if there is none
+static int findPayload(CodecDesc::Media media, const QList<PPayloadInfo> &info)
 {
-    QString     acodec, vcodec;
-    GstElement *audioout = nullptr;
-    GstElement *asrc     = nullptr;
-
-    // TODO: support more than opus
-    int opus_at = -1;
-    for (int n = 0; n < remoteAudioPayloadInfo.count(); ++n) {
-        const PPayloadInfo &ri = remoteAudioPayloadInfo[n];
-        if (ri.name.toUpper() == "OPUS") {
-            opus_at = n;
-        }
+    for (int n = 0; n < info.count(); ++n) {
+        if (codecs_findPayload(media, info[n]))
+            return n;
     }
+    return -1;
+}
 
-    // TODO: support more than vp8
-    int vp8_at = -1;
-    for (int n = 0; n < remoteVideoPayloadInfo.count(); ++n) {
-        const PPayloadInfo &ri = remoteVideoPayloadInfo[n];
-        if (ri.name.toUpper() == "VP8" && ri.clockrate == 90000) {
-            vp8_at = n;
-            break;
-        }
+// the first of the local params we have a codec for, or else the first
+//   codec we advertise
+template <typename P> static const CodecDesc *sendCodec(CodecDesc::Media media, const QList<P> &params)
+{
+    for (const P &p : params) {
+        if (const CodecDesc *c = codecs_find(media, p.codec))
+            return c;
+    }
+    for (const CodecDesc *c : codecs_available(media)) {
+        if (c->modes)
+            return c;
     }
+    return nullptr;
+}
+
+bool RtpWorker::startRecv()
+{
+    // stale if an earlier attempt failed
+    recvBranch[0].clear();
+    recvBranch[1].clear();
+
+    int audio_at = findPayload(CodecDesc::Audio, remoteAudioPayloadInfo);
+    int video_at = findPayload(CodecDesc::Video, remoteVideoPayloadInfo);
 
     // if remote does not support our codecs, error out
-    // FIXME: again, support more than opus/vp8
-    if ((!remoteAudioPayloadInfo.isEmpty() && opus_at == -1) || (!remoteVideoPayloadInfo.isEmpty() && vp8_at == -1)) {
+    if ((!remoteAudioPayloadInfo.isEmpty() && audio_at == -1)
+        || (!remoteVideoPayloadInfo.isEmpty() && video_at == -1)) {
         return false;
     }
 
-    if (!remoteAudioPayloadInfo.isEmpty() && opus_at != -1) {
-#ifdef RTPWORKER_DEBUG
-        qDebug("setting up audio recv");
-#endif
+    // no desire to receive
+    if (audio_at == -1 && video_at == -1)
+        return true;
 
-        int at = opus_at;
+    recvbin    = gst_bin_new("recvbin");
+    recvrtpbin = bins_rtpbin_create("recvrtpbin");
+    if (!recvrtpbin)
+        goto fail1;
 
-        GstStructure *cs = payloadInfoToStructure(remoteAudioPayloadInfo[at], "audio");
-        if (!cs) {
-#ifdef RTPWORKER_DEBUG
-            qDebug("cannot parse payload info");
-#endif
-            return false;
-        }
+    g_signal_connect(G_OBJECT(recvrtpbin), "pad-added", G_CALLBACK(cb_recvrtpbin_pad_added), this);
+    g_signal_connect(G_OBJECT(recvrtpbin), "request-pt-map", G_CALLBACK(cb_recvrtpbin_request_pt_map), this);
+    if (audioConference) {
+        g_signal_connect(G_OBJECT(recvrtpbin), "on-bye-ssrc", G_CALLBACK(cb_recvrtpbin_ssrc_left), this);
+        g_signal_connect(G_OBJECT(recvrtpbin), "on-timeout", G_CALLBACK(cb_recvrtpbin_ssrc_left), this);
+    }
+    gst_bin_add(GST_BIN(recvbin), recvrtpbin);
 
-        if (recv_in_use)
-            return false;
+    if (audio_at != -1 && !addRecvAudioChain())
+        goto fail1;
 
-        if (!recvbin)
-            recvbin = gst_bin_new("recvbin");
+    if (video_at != -1 && !addRecvVideoChain())
+        goto fail1;
 
-        audiortpsrc_mutex.lock();
-        audiortpsrc = gst_element_factory_make("appsrc", nullptr);
-        audiortpsrc_mutex.unlock();
+    // gst_element_set_locked_state(recvbin, TRUE);
+    gst_bin_add(GST_BIN(rpipeline), recvbin);
 
-        GstCaps *caps = gst_caps_new_empty();
-        gst_caps_append_structure(caps, cs);
-        g_object_set(G_OBJECT(audiortpsrc), "caps", caps, nullptr);
-        gst_caps_unref(caps);
+    if (pd_audiosink)
+        gst_element_link(recvbin, pd_audiosink->element());
 
-        // FIXME: what if we don't have a name and just id?
-        //   it's okay, for now we only support opus which requires
-        //   the name..
-        // UPD 2016-04-16: it's not clear after migrating to opus
-        acodec = remoteAudioPayloadInfo[at].name.toLower();
+    if (shared_clock && send_clock_is_shared) {
+        qDebug("recv pipeline slaving to send clock");
+        gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
     }
 
-    if (!remoteVideoPayloadInfo.isEmpty() && vp8_at != -1) {
+    // gst_element_set_locked_state(recvbin, FALSE);
+    // gst_element_set_state(recvbin, GST_STATE_PLAYING);
 #ifdef RTPWORKER_DEBUG
-        qDebug("setting up video recv");
+    qDebug("activating");
 #endif
 
-        int at = vp8_at;
+    gst_element_set_state(rpipeline, GST_STATE_READY);
+    gst_element_get_state(rpipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+
+    recv_pipelineContext->activate();
+
+    /*if(!shared_clock && use_shared_clock)
+    {
+        qDebug("recv clock is master");
+
+        shared_clock = gst_pipeline_get_clock(GST_PIPELINE(rpipeline));
+        gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
+        recv_clock_is_shared = true;
+    }*/
 
-        GstStructure *cs = payloadInfoToStructure(remoteVideoPayloadInfo[at], "video");
-        if (!cs) {
 #ifdef RTPWORKER_DEBUG
-            qDebug("cannot parse payload info");
+    qDebug("receive pipeline started");
 #endif
-            goto fail1;
-        }
-
-        if (recv_in_use)
-            return false;
+    return true;
 
-        if (!recvbin)
-            recvbin = gst_bin_new("recvbin");
+fail1:
+    // the appsrcs belong to recvbin by now
+    audiortpsrc = nullptr;
+    videortpsrc = nullptr;
 
-        videortpsrc_mutex.lock();
-        videortpsrc = gst_element_factory_make("appsrc", nullptr);
-        videortpsrc_mutex.unlock();
+    if (recvbin) {
+        // pooled decoders may have been added in READY
+        gst_element_set_state(recvbin, GST_STATE_NULL);
+        g_object_unref(G_OBJECT(recvbin));
+        recvbin = nullptr;
+    }
 
-        GstCaps *caps = gst_caps_new_empty();
-        gst_caps_append_structure(caps, cs);
-        g_object_set(G_OBJECT(videortpsrc), "caps", caps, nullptr);
-        gst_caps_unref(caps);
+    recvrtpbin        = nullptr;
+    audiodecbin       = nullptr;
+    videodecbin       = nullptr;
+    audiortcpsrc_recv = nullptr;
+    videortcpsrc_recv = nullptr;
 
-        // FIXME: what if we don't have a name and just id?
-        //   it's okay, for now we only really support vp8 which
-        //   requires the name..
-        vcodec = remoteVideoPayloadInfo[at].name;
-        if (vcodec == "H263-1998") // FIXME: gross
-            vcodec = "h263p";
-        else
-            vcodec = vcodec.toLower();
+    {
+        QMutexLocker locker(&volumeout_mutex);
+        volumeout = nullptr;
     }
 
-    // no desire to receive
-    if (!recvbin)
-        return true;
+    participants_mutex.lock();
+    audiomixer = nullptr;
+    participants_mutex.unlock();
+
+    delete pd_audiosink;
+    pd_audiosink = nullptr;
 
-    recv_in_use = true;
+    return false;
+}
 
-    if (audiortpsrc) {
-        GstElement *audiodec = bins_audiodec_create(acodec);
-        if (!audiodec)
-            goto fail1;
+// the audio half of the receive side. recvbin and recvrtpbin must exist.
+//   when playing to a device, recvbin gets a "src" pad for it, which the
+//   caller links once recvbin is in the pipeline
+bool RtpWorker::addRecvAudioChain()
+{
+    int at = findPayload(CodecDesc::Audio, remoteAudioPayloadInfo);
+    if (at == -1)
+        return false;
 
-        if (!aout.isEmpty()) {
 #ifdef RTPWORKER_DEBUG
-            qDebug("creating audioout");
+    qDebug("setting up audio recv");
 #endif
 
-            pd_audiosink
-                = PipelineDeviceContext::create(recv_pipelineContext, aout, PDevice::AudioOut, hardwareDeviceMonitor_);
-            if (!pd_audiosink) {
+    GstStructure *cs = payloadInfoToStructure(remoteAudioPayloadInfo[at], "audio");
+    if (!cs) {
 #ifdef RTPWORKER_DEBUG
-                qDebug("failed to create audio output element");
+        qDebug("cannot parse payload info");
 #endif
-                goto fail1;
-            }
-            if (pd_audiosrc) {
-                PipelineDeviceOptions opts = pd_audiosrc->options();
-                opts.aec                   = true;
-                opts.echoProberName        = pd_audiosink->options().echoProberName;
-                pd_audiosrc->setOptions(opts);
-            }
-
-            audioout = pd_audiosink->element();
-        } else
-            audioout = gst_element_factory_make("fakesink", nullptr);
-
-        {
-            QMutexLocker locker(&volumeout_mutex);
-            volumeout  = gst_element_factory_make("volume", nullptr);
-            double vol = double(outputVolume) / 100;
-            g_object_set(G_OBJECT(volumeout), "volume", vol, nullptr);
-        }
-
-        GstElement *audioconvert  = gst_element_factory_make("audioconvert", nullptr);
-        GstElement *audioresample = gst_element_factory_make("audioresample", nullptr);
-        if (pd_audiosink)
-            asrc = audioresample;
-
-        gst_bin_add(GST_BIN(recvbin), audiortpsrc);
-        gst_bin_add(GST_BIN(recvbin), audiodec);
-        gst_bin_add(GST_BIN(recvbin), volumeout);
-        gst_bin_add(GST_BIN(recvbin), audioconvert);
-        gst_bin_add(GST_BIN(recvbin), audioresample);
-        if (!asrc)
-            gst_bin_add(GST_BIN(recvbin), audioout);
-
-        gst_element_link_many(audiortpsrc, audiodec, volumeout, audioconvert, audioresample, nullptr);
-        if (!asrc)
-            gst_element_link(audioresample, audioout);
-
-        actual_remoteAudioPayloadInfo = remoteAudioPayloadInfo;
+        return false;
     }
 
-    if (videortpsrc) {
-        GstElement *videodec = bins_videodec_create(vcodec);
-        if (!videodec)
-            goto fail1;
+    QString acodec = QString::fromLatin1(codecs_findPayload(CodecDesc::Audio, remoteAudioPayloadInfo[at])->name);
 
-        GstElement *videoconvert = gst_element_factory_make("videoconvert", nullptr);
-        GstAppSink *appVideoSink = makeVideoPlayAppSink("netvideoplay");
+    // in conference mode the mixer takes the decoder's place, and
+    //   decoders are added per participant as their ssrcs show up
+    GstElement *audiodec = audioConference ? gst_element_factory_make("audiomixer", nullptr)
+                                           : BinPool::instance()->audiodec(acodec, opusOptions);
+    if (!audiodec) {
+        gst_structure_free(cs);
+        return false;
+    }
 
-        GstAppSinkCallbacks sinkVideoCb;
-        sinkVideoCb.new_sample  = cb_show_frame_output;
-        sinkVideoCb.eos         = cb_packet_ready_eos_stub;     // TODO
-        sinkVideoCb.new_preroll = cb_packet_ready_preroll_stub; // TODO
-#if GST_CHECK_VERSION(1, 22, 0)
-        sinkVideoCb.new_event = cb_packet_ready_event_stub; // TODO
+    GstElement *audioout = nullptr;
+    if (!aout.isEmpty()) {
+#ifdef RTPWORKER_DEBUG
+        qDebug("creating audioout");
 #endif
-#if GST_CHECK_VERSION(1, 24, 0)
-        sinkVideoCb.propose_allocation = cb_packet_ready_allocation_stub; // TODO
+
+        pd_audiosink
+            = PipelineDeviceContext::create(recv_pipelineContext, aout, PDevice::AudioOut, hardwareDeviceMonitor_);
+        if (!pd_audiosink) {
+#ifdef RTPWORKER_DEBUG
+            qDebug("failed to create audio output element");
 #endif
-        gst_app_sink_set_callbacks(appVideoSink, &sinkVideoCb, this, nullptr);
+            gst_structure_free(cs);
+            gst_element_set_state(audiodec, GST_STATE_NULL);
+            gst_object_ref_sink(audiodec);
+            gst_object_unref(audiodec);
+            return false;
+        }
+        if (pd_audiosrc) {
+            PipelineDeviceOptions opts = pd_audiosrc->options();
+            opts.aec                   = true;
+            opts.echoProberName        = pd_audiosink->options().echoProberName;
+            pd_audiosrc->setOptions(opts);
+        }
+    } else
+        audioout = gst_element_factory_make("fakesink", nullptr);
 
-        gst_bin_add(GST_BIN(recvbin), videortpsrc);
-        gst_bin_add(GST_BIN(recvbin), videodec);
-        gst_bin_add(GST_BIN(recvbin), videoconvert);
-        gst_bin_add(GST_BIN(recvbin), (GstElement *)appVideoSink);
+    audiortpsrc = gst_element_factory_make("appsrc", nullptr);
 
-        gst_element_link_many(videortpsrc, videodec, videoconvert, (GstElement *)appVideoSink, nullptr);
+    GstCaps *caps = gst_caps_new_empty();
+    gst_caps_append_structure(caps, cs);
+    g_object_set(G_OBJECT(audiortpsrc), "caps", caps, nullptr);
+    gst_caps_unref(caps);
 
-        actual_remoteVideoPayloadInfo = remoteVideoPayloadInfo;
+    if (audioConference) {
+        // a live source lets the mixer time out on silent participants
+        //   instead of waiting for them
+        g_object_set(G_OBJECT(audiortpsrc), "is-live", TRUE, "format", GST_FORMAT_TIME, "do-timestamp", TRUE,
+                     nullptr);
+        recvAudioCodec = acodec;
     }
 
-    // gst_element_set_locked_state(recvbin, TRUE);
-    gst_bin_add(GST_BIN(rpipeline), recvbin);
+    {
+        QMutexLocker locker(&volumeout_mutex);
+        volumeout  = gst_element_factory_make("volume", nullptr);
+        double vol = double(outputVolume) / 100;
+        g_object_set(G_OBJECT(volumeout), "volume", vol, nullptr);
+    }
+
+    GstElement *audioconvert  = gst_element_factory_make("audioconvert", nullptr);
+    GstElement *audioresample = gst_element_factory_make("audioresample", nullptr);
 
-    if (asrc) {
-        GstPad *pad = gst_element_get_static_pad(asrc, "src");
+    if (audioConference) {
+        QMutexLocker locker(&participants_mutex);
+        audiomixer = audiodec;
+    } else
+        audiodecbin = audiodec;
+
+    gst_bin_add(GST_BIN(recvbin), audiortpsrc);
+    gst_bin_add(GST_BIN(recvbin), audiodec);
+    gst_bin_add(GST_BIN(recvbin), volumeout);
+    gst_bin_add(GST_BIN(recvbin), audioconvert);
+    gst_bin_add(GST_BIN(recvbin), audioresample);
+    if (audioout)
+        gst_bin_add(GST_BIN(recvbin), audioout);
+    recvBranch[0] << audiortpsrc << audiodec << volumeout << audioconvert << audioresample;
+    if (audioout)
+        recvBranch[0] += audioout;
+
+    // the decoder is linked to the rtpbin once the ssrc is known
+    gst_element_link_pads(audiortpsrc, "src", recvrtpbin, "recv_rtp_sink_0");
+    gst_element_link_many(audiodec, volumeout, audioconvert, audioresample, nullptr);
+    if (audioout)
+        gst_element_link(audioresample, audioout);
+    addRtcpChain(recvbin, recvrtpbin, 0, &audiortcpsrc_recv);
+
+    if (pd_audiosink) {
+        GstPad *pad = gst_element_get_static_pad(audioresample, "src");
         gst_element_add_pad(
             recvbin, gst_ghost_pad_new_from_template("src", pad, gst_static_pad_template_get(&raw_audio_src_template)));
         gst_object_unref(GST_OBJECT(pad));
-
-        gst_element_link(recvbin, audioout);
     }
 
-    if (shared_clock && send_clock_is_shared) {
-        qDebug("recv pipeline slaving to send clock");
-        gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
+    // from here the audio is only mixed with that of other sessions
+    //   and played, which the pipeline latency covers
+    if (!audioConference) {
+        GstPad *pad = gst_element_get_static_pad(audioresample, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_play_audio, this, nullptr);
+        gst_object_unref(pad);
     }
 
-    // gst_element_set_locked_state(recvbin, FALSE);
-    // gst_element_set_state(recvbin, GST_STATE_PLAYING);
+    actual_remoteAudioPayloadInfo = remoteAudioPayloadInfo;
+    return true;
+}
+
+// the video half of the receive side. recvbin and recvrtpbin must exist
+bool RtpWorker::addRecvVideoChain()
+{
+    int at = findPayload(CodecDesc::Video, remoteVideoPayloadInfo);
+    if (at == -1)
+        return false;
+
 #ifdef RTPWORKER_DEBUG
-    qDebug("activating");
+    qDebug("setting up video recv");
 #endif
 
-    gst_element_set_state(rpipeline, GST_STATE_READY);
-    gst_element_get_state(rpipeline, nullptr, nullptr, GST_CLOCK_TIME_NONE);
+    GstStructure *cs = payloadInfoToStructure(remoteVideoPayloadInfo[at], "video");
+    if (!cs) {
+#ifdef RTPWORKER_DEBUG
+        qDebug("cannot parse payload info");
+#endif
+        return false;
+    }
 
-    recv_pipelineContext->activate();
+    QString vcodec = QString::fromLatin1(codecs_findPayload(CodecDesc::Video, remoteVideoPayloadInfo[at])->name);
 
-    /*if(!shared_clock && use_shared_clock)
-    {
-        qDebug("recv clock is master");
+    GstElement *videodec = BinPool::instance()->videodec(vcodec);
+    if (!videodec) {
+        gst_structure_free(cs);
+        return false;
+    }
 
-        shared_clock = gst_pipeline_get_clock(GST_PIPELINE(rpipeline));
-        gst_pipeline_use_clock(GST_PIPELINE(rpipeline), shared_clock);
-        recv_clock_is_shared = true;
-    }*/
+    videortpsrc = gst_element_factory_make("appsrc", nullptr);
 
-#ifdef RTPWORKER_DEBUG
-    qDebug("receive pipeline started");
-#endif
-    return true;
+    GstCaps *caps = gst_caps_new_empty();
+    gst_caps_append_structure(caps, cs);
+    g_object_set(G_OBJECT(videortpsrc), "caps", caps, nullptr);
+    gst_caps_unref(caps);
 
-fail1:
-    audiortpsrc_mutex.lock();
-    if (audiortpsrc) {
-        g_object_unref(G_OBJECT(audiortpsrc));
-        audiortpsrc = nullptr;
-    }
-    audiortpsrc_mutex.unlock();
+    GstElement *videoconvert = gst_element_factory_make("videoconvert", nullptr);
+    GstAppSink *appVideoSink = makeVideoPlayAppSink("netvideoplay");
 
-    videortpsrc_mutex.lock();
-    if (videortpsrc) {
-        g_object_unref(G_OBJECT(videortpsrc));
-        videortpsrc = nullptr;
-    }
-    videortpsrc_mutex.unlock();
+    // frames are shown on the pipeline clock, the one audio plays on as
+    //   well, and the decoder is told to skip ahead rather than fall behind
+    g_object_set(G_OBJECT(appVideoSink), "max-lateness", gint64(20 * GST_MSECOND), "qos", TRUE, nullptr);
 
-    if (recvbin) {
-        g_object_unref(G_OBJECT(recvbin));
-        recvbin = nullptr;
-    }
+    GstAppSinkCallbacks sinkVideoCb;
+    sinkVideoCb.new_sample  = cb_show_frame_output;
+    sinkVideoCb.eos         = cb_packet_ready_eos_stub;     // TODO
+    sinkVideoCb.new_preroll = cb_packet_ready_preroll_stub; // TODO
+#if GST_CHECK_VERSION(1, 22, 0)
+    sinkVideoCb.new_event = cb_packet_ready_event_stub; // TODO
+#endif
+#if GST_CHECK_VERSION(1, 24, 0)
+    sinkVideoCb.propose_allocation = cb_packet_ready_allocation_stub; // TODO
+#endif
+    gst_app_sink_set_callbacks(appVideoSink, &sinkVideoCb, this, nullptr);
 
-    delete pd_audiosink;
-    pd_audiosink = nullptr;
+    videodecbin = videodec;
 
-    recv_in_use = false;
+    gst_bin_add(GST_BIN(recvbin), videortpsrc);
+    gst_bin_add(GST_BIN(recvbin), videodec);
+    gst_bin_add(GST_BIN(recvbin), videoconvert);
+    gst_bin_add(GST_BIN(recvbin), (GstElement *)appVideoSink);
+    recvBranch[1] << videortpsrc << videodec << videoconvert << (GstElement *)appVideoSink;
 
-    return false;
+    gst_element_link_pads(videortpsrc, "src", recvrtpbin, "recv_rtp_sink_1");
+    gst_element_link_many(videodec, videoconvert, (GstElement *)appVideoSink, nullptr);
+    addRtcpChain(recvbin, recvrtpbin, 1, &videortcpsrc_recv);
+
+    GstPad *pad = gst_element_get_static_pad((GstElement *)appVideoSink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_play_video, this, nullptr);
+    gst_object_unref(pad);
+
+    actual_remoteVideoPayloadInfo = remoteVideoPayloadInfo;
+    return true;
 }
 
 bool RtpWorker::addAudioChain() { return addAudioChain(16000); }
 
 bool RtpWorker::addAudioChain(int rate)
 {
-    // TODO: support other codecs.  for now, we only support opus 16khz
-    QString codec    = "opus";
+    const CodecDesc *desc = sendCodec(CodecDesc::Audio, localAudioParams);
+    if (!desc)
+        return false;
+
+    // the format is the one tuned for opus 16khz, unless the codec only
+    //   does one rate
+    QString codec    = QString::fromLatin1(desc->name);
     int     size     = 16;
     int     channels = 2;
-    // QString codec = localAudioParams[0].codec;
-    // int rate = localAudioParams[0].sampleRate;
-    // int size = localAudioParams[0].sampleSize;
-    // int channels = localAudioParams[0].channels;
+    if (desc->clockRate > 0)
+        rate = desc->clockRate;
 #ifdef RTPWORKER_DEBUG
     qDebug("codec=%s", qPrintable(codec));
 #endif
 
-    // see if we need to match a pt id
-    int pt = -1;
+    // see if we need to match a pt id. the codec table checks the clock
+    //   rate where it is fixed, opus runs its rtp clock at 48khz whatever
+    //   the rate we encode at
+    int          pt   = -1;
+    POpusOptions opus = opusOptions;
     for (int n = 0; n < remoteAudioPayloadInfo.count(); ++n) {
         const PPayloadInfo &ri = remoteAudioPayloadInfo[n];
-        if (ri.name.toUpper() == "OPUS" && ri.clockrate == rate) {
+        if (codecs_findPayload(CodecDesc::Audio, ri, true) == desc) {
             pt = ri.id;
+            // packets as long as the peer asks for, or the encoder's 20ms,
+            //   within what it takes
+            if (opus.frameSize <= 0)
+                opus.frameSize = ri.ptime > 0 ? ri.ptime : 20;
+            if (ri.maxptime > 0 && opus.frameSize > ri.maxptime)
+                opus.frameSize = ri.maxptime;
             break;
         }
     }
 
     // NOTE: we don't bother with a maxbitrate constraint on audio yet
 
-    GstElement *audioenc = bins_audioenc_create(codec, pt, rate, size, channels);
+    GstElement *audioenc = BinPool::instance()->audioenc(codec, pt, rate, size, channels, opus);
     if (!audioenc)
         return false;
 
@@ -1467,6 +3157,8 @@ bool RtpWorker::addAudioChain(int rate)
         g_object_set(G_OBJECT(volumein), "volume", vol, nullptr);
     }
 
+    GstElement *valve = gst_element_factory_make("valve", nullptr);
+
     GstElement *audiortpsink = gst_element_factory_make("appsink", nullptr);
     auto        appRtpSink   = GST_APP_SINK(audiortpsink);
 
@@ -1485,6 +3177,15 @@ bool RtpWorker::addAudioChain(int rate)
 #endif
     gst_app_sink_set_callbacks(appRtpSink, &sinkCb, this, nullptr);
 
+    GstElement *rtpbin = ensureSendRtpBin();
+    if (!rtpbin) {
+        gst_element_set_state(audioenc, GST_STATE_NULL);
+        g_object_unref(G_OBJECT(audioenc));
+        g_object_unref(G_OBJECT(valve));
+        g_object_unref(G_OBJECT(audiortpsink));
+        return false;
+    }
+
     GstElement *queue = nullptr;
     if (fileDemux)
         queue = gst_element_factory_make("queue", "queue_filedemuxaudio");
@@ -1493,18 +3194,36 @@ bool RtpWorker::addAudioChain(int rate)
         gst_bin_add(GST_BIN(sendbin), queue);
 
     gst_bin_add(GST_BIN(sendbin), volumein);
+    gst_bin_add(GST_BIN(sendbin), valve);
     gst_bin_add(GST_BIN(sendbin), audioenc);
     gst_bin_add(GST_BIN(sendbin), audiortpsink);
+    if (queue)
+        sendBranch[0] += queue;
+    sendBranch[0] << volumein << valve << audioenc << audiortpsink;
 
-    gst_element_link_many(volumein, audioenc, audiortpsink, nullptr);
+    gst_element_link_many(volumein, valve, audioenc, nullptr);
+    gst_element_link_pads(audioenc, "src", rtpbin, "send_rtp_sink_0");
+    gst_element_link_pads(rtpbin, "send_rtp_src_0", audiortpsink, "sink");
+    addRtcpChain(sendbin, rtpbin, 0, &audiortcpsrc_send);
 
     audiortppay = audioenc;
+    {
+        // the encoder has to see data before the payloader knows its caps,
+        //   which the payload info comes from, so the valve is only matched
+        //   to transmission once those are out
+        QMutexLocker locker(&rtpaudioout_mutex);
+        audiovalve  = valve;
+        GstPad *pad = gst_element_get_static_pad(audioenc, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, cb_audio_negotiated, this, nullptr);
+        gst_object_unref(pad);
+    }
 
     if (fileDemux) {
         gst_element_link(queue, volumein);
 
         gst_element_set_state(queue, GST_STATE_PAUSED);
         gst_element_set_state(volumein, GST_STATE_PAUSED);
+        gst_element_set_state(valve, GST_STATE_PAUSED);
         gst_element_set_state(audioenc, GST_STATE_PAUSED);
         gst_element_set_state(audiortpsink, GST_STATE_PAUSED);
 
@@ -1523,13 +3242,16 @@ bool RtpWorker::addAudioChain(int rate)
 
 bool RtpWorker::addVideoChain()
 {
-    // TODO: support other codecs.  for now, we only support vp8
-    QString codec = "vp8";
-    QSize   size  = QSize(640, 480);
-    int     fps   = 30;
-    // QString codec = localVideoParams[0].codec;
-    // QSize size = localVideoParams[0].size;
-    // int fps = localVideoParams[0].fps;
+    const CodecDesc *desc = sendCodec(CodecDesc::Video, localVideoParams);
+    if (!desc)
+        return false;
+
+    // the capture is scaled to the negotiated mode, which the encoder is
+    //   tuned for as well
+    PVideoParams mode  = localVideoParams.value(0);
+    QString      codec = QString::fromLatin1(desc->name);
+    QSize        size  = mode.size.isValid() ? mode.size : QSize(640, 480);
+    int          fps   = mode.fps > 0 ? mode.fps : 30;
 #ifdef RTPWORKER_DEBUG
     qDebug("codec=%s", qPrintable(codec));
 #endif
@@ -1538,23 +3260,23 @@ bool RtpWorker::addVideoChain()
     int pt = -1;
     for (int n = 0; n < remoteVideoPayloadInfo.count(); ++n) {
         const PPayloadInfo &ri = remoteVideoPayloadInfo[n];
-        if (ri.name.toUpper() == "VP8" && ri.clockrate == 90000) {
+        if (codecs_findPayload(CodecDesc::Video, ri, true) == desc) {
             pt = ri.id;
             break;
         }
     }
 
     int videokbps = maxbitrate;
-    // NOTE: we assume audio takes 45kbps
-    if (audiortppay)
-        videokbps -= 45;
+    // NOTE: we assume audio takes 45kbps, unless the opus bitrate is set
+    if (audiortppay && videokbps != -1)
+        videokbps = qMax(videokbps - (opusOptions.bitrate > 0 ? opusOptions.bitrate : 45), 1);
 
 #ifdef VIDEO_PREP
     GstElement *videoprep = bins_videoprep_create(size, fps, fileDemux ? false : true);
     if (!videoprep)
         return false;
 #endif
-    GstElement *videoenc = bins_videoenc_create(codec, pt, videokbps);
+    GstElement *videoenc = BinPool::instance()->videoenc(codec, pt, videokbps, size, realtimeVideo);
     if (!videoenc) {
 #ifdef VIDEO_PREP
         g_object_unref(G_OBJECT(videoprep));
@@ -1581,10 +3303,14 @@ bool RtpWorker::addVideoChain()
     gst_app_sink_set_callbacks(appVideoSink, &sinkPreviewCb, this, nullptr);
 
     GstElement *rtpqueue     = gst_element_factory_make("queue", "queue_rtp");
+    GstElement *valve        = gst_element_factory_make("valve", nullptr);
     GstElement *videortpsink = gst_element_factory_make("appsink", nullptr); // was apprtpsink
     auto        appRtpSink   = GST_APP_SINK(videortpsink);
     if (!fileDemux)
         g_object_set(G_OBJECT(appRtpSink), "sync", FALSE, nullptr);
+#if GST_CHECK_VERSION(1, 12, 0)
+    g_object_set(G_OBJECT(appRtpSink), "buffer-list", TRUE, nullptr);
+#endif
 
     GstAppSinkCallbacks sinkCb;
     sinkCb.new_sample  = cb_packet_ready_rtp_video;
@@ -1598,6 +3324,23 @@ bool RtpWorker::addVideoChain()
 #endif
     gst_app_sink_set_callbacks(appRtpSink, &sinkCb, this, nullptr);
 
+    GstElement *rtpbin = ensureSendRtpBin();
+    if (!rtpbin) {
+        gst_element_set_state(videoenc, GST_STATE_NULL);
+        g_object_unref(G_OBJECT(videoenc));
+        g_object_unref(G_OBJECT(videotee));
+        g_object_unref(G_OBJECT(playqueue));
+        g_object_unref(G_OBJECT(videoconvertplay));
+        g_object_unref(G_OBJECT(appVideoSink));
+        g_object_unref(G_OBJECT(rtpqueue));
+        g_object_unref(G_OBJECT(valve));
+        g_object_unref(G_OBJECT(videortpsink));
+#ifdef VIDEO_PREP
+        g_object_unref(G_OBJECT(videoprep));
+#endif
+        return false;
+    }
+
     GstElement *queue = nullptr;
     if (fileDemux)
         queue = gst_element_factory_make("queue", "queue_filedemuxvideo");
@@ -1612,15 +3355,34 @@ bool RtpWorker::addVideoChain()
     gst_bin_add(GST_BIN(sendbin), videoconvertplay);
     gst_bin_add(GST_BIN(sendbin), reinterpret_cast<GstElement *>(appVideoSink));
     gst_bin_add(GST_BIN(sendbin), rtpqueue);
+    gst_bin_add(GST_BIN(sendbin), valve);
     gst_bin_add(GST_BIN(sendbin), videoenc);
     gst_bin_add(GST_BIN(sendbin), videortpsink);
+    if (queue)
+        sendBranch[1] += queue;
+#ifdef VIDEO_PREP
+    sendBranch[1] += videoprep;
+#endif
+    sendBranch[1] << videotee << playqueue << videoconvertplay << reinterpret_cast<GstElement *>(appVideoSink)
+                  << rtpqueue << valve << videoenc << videortpsink;
 #ifdef VIDEO_PREP
     gst_element_link(videoprep, videotee);
 #endif
     gst_element_link_many(videotee, playqueue, videoconvertplay, reinterpret_cast<GstElement *>(appVideoSink), nullptr);
-    gst_element_link_many(videotee, rtpqueue, videoenc, videortpsink, nullptr); // FIXME!
+    gst_element_link_many(videotee, rtpqueue, valve, videoenc, nullptr); // FIXME!
+    gst_element_link_pads(videoenc, "src", rtpbin, "send_rtp_sink_1");
+    gst_element_link_pads(rtpbin, "send_rtp_src_1", videortpsink, "sink");
+    addRtcpChain(sendbin, rtpbin, 1, &videortcpsrc_send);
 
     videortppay = videoenc;
+    {
+        // same as for audio
+        QMutexLocker locker(&rtpvideoout_mutex);
+        videovalve  = valve;
+        GstPad *pad = gst_element_get_static_pad(videoenc, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, cb_video_negotiated, this, nullptr);
+        gst_object_unref(pad);
+    }
 
     if (fileDemux) {
 #ifdef VIDEO_PREP
@@ -1638,6 +3400,7 @@ bool RtpWorker::addVideoChain()
         gst_element_set_state(videoconvertplay, GST_STATE_PAUSED);
         gst_element_set_state(reinterpret_cast<GstElement *>(appVideoSink), GST_STATE_PAUSED);
         gst_element_set_state(rtpqueue, GST_STATE_PAUSED);
+        gst_element_set_state(valve, GST_STATE_PAUSED);
         gst_element_set_state(videoenc, GST_STATE_PAUSED);
         gst_element_set_state(videortpsink, GST_STATE_PAUSED);
 
@@ -1754,7 +3517,6 @@ bool RtpWorker::updateVp8Config()
                 continue;
             }
 
-            QMutexLocker locker(&videortpsrc_mutex);
             if (!videortpsrc)
                 continue;
 
@@ -1764,6 +3526,10 @@ bool RtpWorker::updateVp8Config()
             g_object_set(G_OBJECT(videortpsrc), "caps", caps, nullptr);
             gst_caps_unref(caps);
 
+            // make the jitterbuffer ask for the new caps
+            if (recvrtpbin)
+                g_signal_emit_by_name(recvrtpbin, "clear-pt-map");
+
             actual_remoteVideoPayloadInfo[vp8_at] = ri;
             return true;
         }
@@ -22,15 +22,19 @@
 #define RTPWORKER_H
 
 #include "psimediaprovider.h"
+#include "rtpingressqueue.h"
 #include <QByteArray>
 #include <QImage>
+#include <QMap>
 #include <QMutex>
+#include <QSet>
 #include <QString>
 #include <gst/app/gstappsink.h>
 #include <gst/gst.h>
 
 namespace PsiMedia {
 
+class PipelineContext;
 class PipelineDeviceContext;
 class DeviceMonitor;
 class Stats;
@@ -61,7 +65,13 @@ public:
     QList<PPayloadInfo> localVideoPayloadInfo;
     QList<PPayloadInfo> remoteAudioPayloadInfo;
     QList<PPayloadInfo> remoteVideoPayloadInfo;
-    int                 maxbitrate = -1;
+    int                 maxbitrate    = -1;
+    bool                realtimeVideo = true; // read when the video encoder is built
+    POpusOptions        opusOptions;          // read when opus elements are built
+
+    // decode every remote audio ssrc on its own and mix them for playback,
+    //   rather than following only the newest one. read at start
+    bool audioConference = false;
 
     // read-only
     bool canTransmitAudio = false;
@@ -84,13 +94,42 @@ public:
     void pauseVideo();
     void stop(); // can be called at any time after calling start
 
-    // the rtp input functions are safe to call from any thread
+    // hold lets go of the capture and playback devices and parks both
+    //   pipelines in READY, keeping the codecs, payload types and rtp
+    //   sessions. resume reopens the devices and carries on without any
+    //   renegotiation. no effect before started, or with file input
+    void hold();
+    void resume();
+
+    // the rtp input functions are safe to call from any thread, but calls
+    //   for the same media must not overlap. they never block. packets
+    //   with a portOffset of 1 are taken as rtcp
     void rtpAudioIn(const PRtpPacket &packet);
     void rtpVideoIn(const PRtpPacket &packet);
+    void rtpAudioIn(const QVector<PRtpPacket> &packets);
+    void rtpVideoIn(const QVector<PRtpPacket> &packets);
+
+    // counters of the inbound packet queues, safe to call from any thread
+    class IngressStats {
+    public:
+        quint64 enqueued = 0;
+        quint64 dropped  = 0;
+    };
+    IngressStats audioIngressStats() const;
+    IngressStats videoIngressStats() const;
 
     void setOutputVolume(int level);
     void setInputVolume(int level);
 
+    // moves running capture and playback over to ain, vin and aout where
+    //   they changed, without restarting. devices that aren't running yet
+    //   are left to start() and update()
+    void switchDevices();
+
+    // gain (0 to 100) and mute of individual conference participants.
+    //   ssrcs not listed play at full volume
+    void setParticipantVolumes(const QMap<quint32, int> &volumes, const QSet<quint32> &muted);
+
     void recordStart();
     void recordStop();
     void dumpPipeline(std::function<void(const QStringList &)> = {});
@@ -113,6 +152,12 @@ public:
     void (*cb_rtpAudioOut)(const PRtpPacket &packet, void *app) = nullptr;
     void (*cb_rtpVideoOut)(const PRtpPacket &packet, void *app) = nullptr;
 
+    // all the rtp packets of one encoded video frame at once
+    void (*cb_rtpVideoOutBatch)(const QVector<PRtpPacket> &packets, void *app) = nullptr;
+
+    // once a second while any rtp session is running
+    void (*cb_statistics)(const PRtpSessionStats &stats, void *app) = nullptr;
+
     // empty record packet = EOF/error
     void (*cb_recordData)(const QByteArray &packet, void *app) = nullptr;
 
@@ -120,28 +165,93 @@ private:
     GMainContext  *mainContext_           = nullptr;
     DeviceMonitor *hardwareDeviceMonitor_ = nullptr;
     GSource       *timer                  = nullptr;
+    GSource       *ingressSource          = nullptr;
+    GSource       *statsTimer             = nullptr;
+    GSource       *capsTimer              = nullptr;
+
+    // PRtpPacket::currentTime() of the start() call, and the ms it took
+    //   until cb_started
+    qint64 startRequested = 0;
+    int    timeToStarted  = -1;
+
+    // inbound rtp is queued here and pushed into the appsrcs from the
+    //   worker's own thread, so the appsrc pointers need no locking
+    RtpIngressQueue audioIngress;
+    RtpIngressQueue videoIngress;
+    RtpIngressQueue audioRtcpIngress;
+    RtpIngressQueue videoRtcpIngress;
+
+    // sessions don't share pipelines or a clock. within a session the
+    //   receive pipeline is slaved to the send clock
+    PipelineContext *send_pipelineContext = nullptr;
+    PipelineContext *recv_pipelineContext = nullptr;
+    GstElement      *spipeline            = nullptr;
+    GstElement      *rpipeline            = nullptr;
+    GstClock        *shared_clock         = nullptr;
+    bool             send_clock_is_shared = false;
 
     PipelineDeviceContext *pd_audiosrc = nullptr, *pd_videosrc = nullptr, *pd_audiosink = nullptr;
     GstElement            *sendbin = nullptr, *recvbin = nullptr;
+    bool                   held    = false; // the pd_* are released while held
 
     GstElement *fileDemux   = nullptr;
     GstElement *audiosrc    = nullptr;
     GstElement *videosrc    = nullptr;
     GstElement *audiortpsrc = nullptr;
     GstElement *videortpsrc = nullptr;
+    GstElement *audiodecbin = nullptr;
+    GstElement *videodecbin = nullptr;
+
+    // the elements of each media (session) in sendbin and recvbin, so
+    //   that a branch can be taken out again while the other one runs
+    QList<GstElement *> sendBranch[2];
+    QList<GstElement *> recvBranch[2];
+
+    // send branches added to a running session, waiting for their
+    //   payloaders to negotiate
+    bool pendingCaps[2] = { false, false };
+    int  capsWaitLeft   = 0;
+
+    // rtcp: session 0 is audio, session 1 is video. incoming rtcp goes to
+    //   both bins, since it carries reports for either direction
+    GstElement *sendrtpbin        = nullptr;
+    GstElement *recvrtpbin        = nullptr;
+    GstElement *audiortcpsrc_send = nullptr;
+    GstElement *videortcpsrc_send = nullptr;
+    GstElement *audiortcpsrc_recv = nullptr;
+    GstElement *videortcpsrc_recv = nullptr;
     GstElement *audiortppay = nullptr;
     GstElement *videortppay = nullptr;
     GstElement *volumein    = nullptr;
     GstElement *volumeout   = nullptr;
+    GstElement *audiovalve  = nullptr; // closed while paused, under rtpaudioout_mutex
+    GstElement *videovalve  = nullptr; // same, under rtpvideoout_mutex
     bool        rtpaudioout = false;
     bool        rtpvideoout = false;
-    QMutex      audiortpsrc_mutex;
-    QMutex      videortpsrc_mutex;
     QMutex      volumein_mutex;
     QMutex      volumeout_mutex;
     QMutex      rtpaudioout_mutex;
     QMutex      rtpvideoout_mutex;
 
+    // conference mode: one decoder and volume per remote ssrc feeding the
+    //   mixer. participants are created from rtpbin's streaming threads
+    class Participant {
+    public:
+        GstElement *decoder = nullptr;
+        GstElement *volume  = nullptr;
+    };
+    GstElement                 *audiomixer = nullptr;
+    QString                    recvAudioCodec;
+    QMap<quint32, Participant> participants;
+    QMap<quint32, int>         participantVolumes;
+    QSet<quint32>              mutedParticipants;
+    QMutex                     participants_mutex;
+
+    // ssrcs that sent a bye or timed out, torn down from our own thread
+    //   by participantsTimer
+    QSet<quint32> leftParticipants;
+    GSource      *participantsTimer = nullptr;
+
     // GSource *recordTimer;
 
     QList<PPayloadInfo> actual_localAudioPayloadInfo;
@@ -152,7 +262,25 @@ private:
     Stats *audioStats = nullptr;
     Stats *videoStats = nullptr;
 
+    // the last rtp timestamp to leave the jitterbuffer of each received
+    //   media, with its pts, and how long after its running time the last
+    //   decoded buffer reached playback. set from the streaming threads
+    class SyncPoint {
+    public:
+        quint32          ssrc    = 0;
+        quint32          rtptime = 0;
+        GstClockTime     pts     = GST_CLOCK_TIME_NONE;
+        GstClockTimeDiff arrival = 0;
+    };
+    SyncPoint syncPoints[2];
+    QMutex    sync_mutex;
+
+    // previous totals of the incoming streams, for loss over an interval
+    quint64 audioInLastPackets = 0, videoInLastPackets = 0;
+    qint64  audioInLastLost = 0, videoInLastLost = 0;
+
     void cleanup();
+    void flushIngress();
 
     static gboolean      cb_doStart(gpointer data);
     static gboolean      cb_doUpdate(gpointer data);
@@ -165,11 +293,29 @@ private:
     static GstFlowReturn cb_show_frame_output(GstAppSink *appsink, gpointer data);
     static GstFlowReturn cb_packet_ready_rtp_audio(GstAppSink *appsink, gpointer data);
     static GstFlowReturn cb_packet_ready_rtp_video(GstAppSink *appsink, gpointer data);
+    static GstFlowReturn cb_packet_ready_rtcp_audio(GstAppSink *appsink, gpointer data);
+    static GstFlowReturn cb_packet_ready_rtcp_video(GstAppSink *appsink, gpointer data);
     static GstFlowReturn cb_packet_ready_preroll_stub(GstAppSink *appsink, gpointer data);
     static void          cb_packet_ready_eos_stub(GstAppSink *appsink, gpointer data);
     static gboolean      cb_packet_ready_event_stub(GstAppSink *appsink, gpointer data);
     static gboolean      cb_packet_ready_allocation_stub(GstAppSink *appsink, GstQuery *query, gpointer user_data);
     static gboolean      cb_fileReady(gpointer data);
+    static gboolean      cb_ingress_prepare(GSource *source, gint *timeout);
+    static gboolean      cb_ingress_check(GSource *source);
+    static gboolean      cb_ingress_dispatch(GSource *source, GSourceFunc callback, gpointer data);
+    static void          cb_recvrtpbin_pad_added(GstElement *element, GstPad *pad, gpointer data);
+    static GstCaps      *cb_recvrtpbin_request_pt_map(GstElement *element, guint session, guint pt, gpointer data);
+    static void          cb_recvrtpbin_ssrc_left(GstElement *element, guint session, guint ssrc, gpointer data);
+    static gboolean      cb_removeParticipants(gpointer data);
+    static gboolean      cb_statsTimeout(gpointer data);
+    static gboolean      cb_capsTimeout(gpointer data);
+
+    static GstPadProbeReturn cb_sync_audio(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn cb_sync_video(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn cb_play_audio(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn cb_play_video(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn cb_audio_negotiated(GstPad *pad, GstPadProbeInfo *info, gpointer data);
+    static GstPadProbeReturn cb_video_negotiated(GstPad *pad, GstPadProbeInfo *info, gpointer data);
 
     gboolean      doStart();
     gboolean      doUpdate();
@@ -182,15 +328,45 @@ private:
     GstFlowReturn show_frame_output(GstAppSink *appsink);
     GstFlowReturn packet_ready_rtp_audio(GstAppSink *appsink);
     GstFlowReturn packet_ready_rtp_video(GstAppSink *appsink);
+    GstFlowReturn packet_ready_rtcp_audio(GstAppSink *appsink);
+    GstFlowReturn packet_ready_rtcp_video(GstAppSink *appsink);
+    void          recvrtpbin_pad_added(GstElement *element, GstPad *pad);
+    void          addParticipant(GstPad *pad, quint32 ssrc);
+    void          participantLeft(quint32 ssrc);
+    void          dropParticipant(const Participant &p, GstElement *bin, GstElement *mixer);
+    gboolean      removeParticipants();
+    void          applyParticipantVolume(quint32 ssrc, const Participant &p);
+    GstCaps      *recvrtpbin_request_pt_map(guint session, guint pt);
+    gboolean      statsTimeout();
+    void          updateSyncPoint(int session, GstPad *pad, GstBuffer *buffer);
+    void          updatePlayPoint(int session, GstPad *pad, GstBuffer *buffer);
+    void          resetSyncPoint(int session);
+    bool          avOffset(int *ms);
+    gboolean      capsTimeout();
     gboolean      fileReady();
+    void          signalStarted();
 
     bool        setupSendRecv();
     bool        startSend();
     bool        startSend(int rate);
     bool        startRecv();
+    bool        updateSendMedia();
+    bool        updateRecvMedia();
+    bool        addSendBranch(int session);
+    void        removeSendBranch(int session);
+    bool        addRecvAudioChain();
+    void        removeRecvAudioChain();
+    bool        addRecvVideoChain();
+    void        removeRecvVideoChain();
+    void        removeBranch(GstElement *bin, GstElement *rtpbin, int session);
+    void        replaceClock(GstElement *pipeline);
+    bool        reopenDevices();
     bool        addAudioChain();
     bool        addAudioChain(int rate);
     bool        addVideoChain();
+    GstElement *ensureSendRtpBin();
+    void        addRtcpChain(GstElement *bin, GstElement *rtpbin, int session, GstElement **rtcpsrc);
+    void        startStatsTimer();
     bool        getCaps();
     bool        updateVp8Config();
     GstAppSink *makeVideoPlayAppSink(const gchar *name);
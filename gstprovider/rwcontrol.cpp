@@ -85,6 +85,23 @@ static RwControlAudioIntensityMessage *getLatestAudioIntensityAndRemoveOthers(QL
     return amsg;
 }
 
+static RwControlStatisticsMessage *getLatestStatisticsAndRemoveOthers(QList<RwControlMessage *> *list)
+{
+    RwControlStatisticsMessage *smsg = nullptr;
+    for (int n = 0; n < list->count(); ++n) {
+        RwControlMessage *msg = list->at(n);
+        if (msg->type == RwControlMessage::Statistics) {
+            // if we already had a msg, discard it and take the next
+            delete smsg;
+
+            smsg = static_cast<RwControlStatisticsMessage *>(msg);
+            list->removeAt(n);
+            --n; // adjust position
+        }
+    }
+    return smsg;
+}
+
 static void simplifyQueue(QList<RwControlMessage *> *list)
 {
     // is there a stop message?
@@ -125,6 +142,10 @@ static void applyDevicesToWorker(RtpWorker *worker, const RwControlConfigDevices
     worker->loopFile = devices.loopFile;
     worker->setOutputVolume(devices.audioOutVolume);
     worker->setInputVolume(devices.audioInVolume);
+    worker->switchDevices();
+
+    worker->audioConference = devices.audioConference;
+    worker->setParticipantVolumes(devices.participantVolumes, devices.mutedParticipants);
 }
 
 static void applyCodecsToWorker(RtpWorker *worker, const RwControlConfigCodecs &codecs)
@@ -138,7 +159,9 @@ static void applyCodecsToWorker(RtpWorker *worker, const RwControlConfigCodecs &
     if (codecs.useRemoteVideoPayloadInfo)
         worker->remoteVideoPayloadInfo = codecs.remoteVideoPayloadInfo;
 
-    worker->maxbitrate = codecs.maximumSendingBitrate;
+    worker->maxbitrate    = codecs.maximumSendingBitrate;
+    worker->realtimeVideo = codecs.realtimeVideoEncoding;
+    worker->opusOptions   = codecs.opusOptions;
 }
 
 //----------------------------------------------------------------------------
@@ -210,6 +233,13 @@ void RwControlLocal::setTransmit(const RwControlTransmit &transmit)
     remote_->postMessage(msg);
 }
 
+void RwControlLocal::setHold(bool held)
+{
+    auto msg  = new RwControlHoldMessage;
+    msg->held = held;
+    remote_->postMessage(msg);
+}
+
 void RwControlLocal::setRecord(const RwControlRecord &record)
 {
     auto msg    = new RwControlRecordMessage;
@@ -221,6 +251,10 @@ void RwControlLocal::rtpAudioIn(const PRtpPacket &packet) { remote_->rtpAudioIn(
 
 void RwControlLocal::rtpVideoIn(const PRtpPacket &packet) { remote_->rtpVideoIn(packet); }
 
+void RwControlLocal::rtpAudioIn(const QVector<PRtpPacket> &packets) { remote_->rtpAudioIn(packets); }
+
+void RwControlLocal::rtpVideoIn(const QVector<PRtpPacket> &packets) { remote_->rtpVideoIn(packets); }
+
 // note: this is executed in the remote thread
 gboolean RwControlLocal::cb_doCreateRemote(gpointer data)
 {
@@ -314,6 +348,18 @@ void RwControlLocal::processMessages()
         }
     }
 
+    // we only care about the latest statistics
+    RwControlStatisticsMessage *smsg = getLatestStatisticsAndRemoveOthers(&list);
+    if (smsg) {
+        PRtpSessionStats stats = smsg->stats;
+        delete smsg;
+        emit statisticsReady(stats);
+        if (!self) {
+            qDeleteAll(list);
+            return;
+        }
+    }
+
     // process the remaining messages
     while (!list.isEmpty()) {
         RwControlMessage *msg = list.takeFirst();
@@ -374,7 +420,9 @@ RwControlRemote::RwControlRemote(GMainContext *mainContext, DeviceMonitor *hardw
     worker->cb_outputFrame          = cb_worker_outputFrame;
     worker->cb_rtpAudioOut          = cb_worker_rtpAudioOut;
     worker->cb_rtpVideoOut          = cb_worker_rtpVideoOut;
+    worker->cb_rtpVideoOutBatch     = cb_worker_rtpVideoOutBatch;
     worker->cb_recordData           = cb_worker_recordData;
+    worker->cb_statistics           = cb_worker_statistics;
 }
 
 RwControlRemote::~RwControlRemote()
@@ -429,11 +477,21 @@ void RwControlRemote::cb_worker_rtpVideoOut(const PRtpPacket &packet, void *app)
     static_cast<RwControlRemote *>(app)->worker_rtpVideoOut(packet);
 }
 
+void RwControlRemote::cb_worker_rtpVideoOutBatch(const QVector<PRtpPacket> &packets, void *app)
+{
+    static_cast<RwControlRemote *>(app)->worker_rtpVideoOutBatch(packets);
+}
+
 void RwControlRemote::cb_worker_recordData(const QByteArray &packet, void *app)
 {
     static_cast<RwControlRemote *>(app)->worker_recordData(packet);
 }
 
+void RwControlRemote::cb_worker_statistics(const PRtpSessionStats &stats, void *app)
+{
+    static_cast<RwControlRemote *>(app)->worker_statistics(stats);
+}
+
 gboolean RwControlRemote::processMessages()
 {
     m.lock();
@@ -529,6 +587,13 @@ bool RwControlRemote::processMessage(RwControlMessage *msg)
             worker->transmitVideo();
         else
             worker->pauseVideo();
+    } else if (msg->type == RwControlMessage::Hold) {
+        auto hmsg = static_cast<RwControlHoldMessage *>(msg);
+
+        if (hmsg->held)
+            worker->hold();
+        else
+            worker->resume();
     } else if (msg->type == RwControlMessage::Record) {
         auto rmsg = static_cast<RwControlRecordMessage *>(msg);
 
@@ -631,12 +696,25 @@ void RwControlRemote::worker_rtpVideoOut(const PRtpPacket &packet)
         local_->cb_rtpVideoOut(packet, local_->app);
 }
 
+void RwControlRemote::worker_rtpVideoOutBatch(const QVector<PRtpPacket> &packets)
+{
+    if (local_->cb_rtpVideoOutBatch)
+        local_->cb_rtpVideoOutBatch(packets, local_->app);
+}
+
 void RwControlRemote::worker_recordData(const QByteArray &packet)
 {
     if (local_->cb_recordData)
         local_->cb_recordData(packet, local_->app);
 }
 
+void RwControlRemote::worker_statistics(const PRtpSessionStats &stats)
+{
+    auto msg   = new RwControlStatisticsMessage;
+    msg->stats = stats;
+    local_->postMessage(msg);
+}
+
 void RwControlRemote::resumeMessages()
 {
     QMutexLocker locker(&m);
@@ -678,4 +756,10 @@ void RwControlRemote::rtpAudioIn(const PRtpPacket &packet) { worker->rtpAudioIn(
 // note: this may be called from the local thread
 void RwControlRemote::rtpVideoIn(const PRtpPacket &packet) { worker->rtpVideoIn(packet); }
 
+// note: this may be called from the local thread
+void RwControlRemote::rtpAudioIn(const QVector<PRtpPacket> &packets) { worker->rtpAudioIn(packets); }
+
+// note: this may be called from the local thread
+void RwControlRemote::rtpVideoIn(const QVector<PRtpPacket> &packets) { worker->rtpVideoIn(packets); }
+
 }
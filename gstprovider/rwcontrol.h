@@ -25,8 +25,10 @@
 #include "rtpworker.h"
 #include <QByteArray>
 #include <QList>
+#include <QMap>
 #include <QMutex>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QTimer>
 #include <QWaitCondition>
@@ -63,6 +65,8 @@ namespace PsiMedia {
 //
 // - Transmit/pause the audio/video streams.  This is fire and forget.
 //
+// - Hold/resume the session.  This is fire and forget.
+//
 // - Start/stop recording a session.  For starting, this is somewhat fire
 //   and forget.  You'll eventually start receiving data packets, but the
 //   assumption is that recording is occurring even before the first packet
@@ -96,8 +100,13 @@ public:
     int        audioOutVolume;
     int        audioInVolume;
 
+    bool               audioConference;
+    QMap<quint32, int> participantVolumes;
+    QSet<quint32>      mutedParticipants;
+
     RwControlConfigDevices() :
-        loopFile(false), useVideoPreview(false), useVideoOut(false), audioOutVolume(-1), audioInVolume(-1)
+        loopFile(false), useVideoPreview(false), useVideoOut(false), audioOutVolume(-1), audioInVolume(-1),
+        audioConference(false)
     {
     }
 };
@@ -114,11 +123,13 @@ public:
     QList<PPayloadInfo> remoteAudioPayloadInfo;
     QList<PPayloadInfo> remoteVideoPayloadInfo;
 
-    int maximumSendingBitrate;
+    int          maximumSendingBitrate;
+    bool         realtimeVideoEncoding;
+    POpusOptions opusOptions;
 
     RwControlConfigCodecs() :
         useLocalAudioParams(false), useLocalVideoParams(false), useRemoteAudioPayloadInfo(false),
-        useRemoteVideoPayloadInfo(false), maximumSendingBitrate(-1)
+        useRemoteVideoPayloadInfo(false), maximumSendingBitrate(-1), realtimeVideoEncoding(true)
     {
     }
 };
@@ -190,10 +201,12 @@ public:
         UpdateDevices,
         UpdateCodecs,
         Transmit,
+        Hold,
         Record,
         Status,
         AudioIntensity,
         Frame,
+        Statistics,
         DumpPileline
     };
 
@@ -245,6 +258,13 @@ public:
     RwControlTransmitMessage() : RwControlMessage(RwControlMessage::Transmit) { }
 };
 
+class RwControlHoldMessage : public RwControlMessage {
+public:
+    bool held = false;
+
+    RwControlHoldMessage() : RwControlMessage(RwControlMessage::Hold) { }
+};
+
 class RwControlRecordMessage : public RwControlMessage {
 public:
     RwControlRecord record;
@@ -273,6 +293,13 @@ public:
     RwControlFrameMessage() : RwControlMessage(RwControlMessage::Frame), frame() { }
 };
 
+class RwControlStatisticsMessage : public RwControlMessage {
+public:
+    PRtpSessionStats stats;
+
+    RwControlStatisticsMessage() : RwControlMessage(RwControlMessage::Statistics) { }
+};
+
 class RwControlLocal : public QObject {
     Q_OBJECT
 
@@ -285,11 +312,14 @@ public:
     void updateDevices(const RwControlConfigDevices &devices);
     void updateCodecs(const RwControlConfigCodecs &codecs);
     void setTransmit(const RwControlTransmit &transmit);
+    void setHold(bool held);
     void setRecord(const RwControlRecord &record);
 
     // can be called from any thread
     void rtpAudioIn(const PRtpPacket &packet);
     void rtpVideoIn(const PRtpPacket &packet);
+    void rtpAudioIn(const QVector<PRtpPacket> &packets);
+    void rtpVideoIn(const QVector<PRtpPacket> &packets);
 
     // can come from any thread.
     // note that it is only safe to assign callbacks prior to starting.
@@ -300,6 +330,8 @@ public:
     void (*cb_rtpVideoOut)(const PRtpPacket &packet, void *app) = nullptr;
     void (*cb_recordData)(const QByteArray &packet, void *app)  = nullptr;
 
+    void (*cb_rtpVideoOutBatch)(const QVector<PRtpPacket> &packets, void *app) = nullptr;
+
     void dumpPipeline(std::function<void(const QStringList &)> callback);
 signals:
     // response to start, stop, updateCodecs, or it could be spontaneous
@@ -309,6 +341,7 @@ signals:
     void outputFrame(const QImage &img);
     void audioOutputIntensityChanged(int intensity);
     void audioInputIntensityChanged(int intensity);
+    void statisticsReady(const PRtpSessionStats &stats);
 
 private slots:
     void processMessages();
@@ -367,7 +400,9 @@ private:
     static void     cb_worker_outputFrame(const RtpWorker::Frame &frame, void *app);
     static void     cb_worker_rtpAudioOut(const PRtpPacket &packet, void *app);
     static void     cb_worker_rtpVideoOut(const PRtpPacket &packet, void *app);
+    static void     cb_worker_rtpVideoOutBatch(const QVector<PRtpPacket> &packets, void *app);
     static void     cb_worker_recordData(const QByteArray &packet, void *app);
+    static void     cb_worker_statistics(const PRtpSessionStats &stats, void *app);
 
     gboolean processMessages();
     void     worker_started();
@@ -381,7 +416,9 @@ private:
     void     worker_outputFrame(const RtpWorker::Frame &frame);
     void     worker_rtpAudioOut(const PRtpPacket &packet);
     void     worker_rtpVideoOut(const PRtpPacket &packet);
+    void     worker_rtpVideoOutBatch(const QVector<PRtpPacket> &packets);
     void     worker_recordData(const QByteArray &packet);
+    void     worker_statistics(const PRtpSessionStats &stats);
 
     void resumeMessages();
 
@@ -392,6 +429,8 @@ private:
     void postMessage(RwControlMessage *msg);
     void rtpAudioIn(const PRtpPacket &packet);
     void rtpVideoIn(const PRtpPacket &packet);
+    void rtpAudioIn(const QVector<PRtpPacket> &packets);
+    void rtpVideoIn(const QVector<PRtpPacket> &packets);
 };
 
 }
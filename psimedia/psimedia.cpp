@@ -21,6 +21,8 @@
 #include "psimedia_p.h"
 
 #include <QMetaMethod>
+#include <QMutex>
+#include <vector>
 
 namespace PsiMedia {
 static AudioParams importAudioParams(const PAudioParams &pp)
@@ -81,6 +83,51 @@ static PayloadInfo importPayloadInfo(const PPayloadInfo &pp)
     return out;
 }
 
+static PUdpTransport exportUdpTransport(const UdpTransport &t)
+{
+    PUdpTransport out;
+    out.localAddress   = t.localAddress;
+    out.localBasePort  = t.localBasePort;
+    out.remoteAddress  = t.remoteAddress;
+    out.remoteBasePort = t.remoteBasePort;
+    return out;
+}
+
+static POpusOptions exportOpusOptions(const OpusOptions &o)
+{
+    POpusOptions out;
+    out.bitrate      = o.bitrate;
+    out.frameSize    = o.frameSize;
+    out.inbandFec    = o.inbandFec;
+    out.expectedLoss = o.expectedLoss;
+    out.dtx          = o.dtx;
+    out.complexity   = o.complexity;
+    return out;
+}
+
+static RtpLatencyStats importRtpLatency(const PRtpLatency &s)
+{
+    RtpLatencyStats out;
+    out.count = s.count;
+    out.total = s.total;
+    out.max   = s.max;
+    return out;
+}
+
+static RtpStreamStats importRtpStreamStats(const PRtpStreamStats &s)
+{
+    RtpStreamStats out;
+    out.ssrc          = s.ssrc;
+    out.packets       = s.packets;
+    out.packetsLost   = s.packetsLost;
+    out.fractionLost  = s.fractionLost;
+    out.jitter        = s.jitter;
+    out.roundTripTime = s.roundTripTime;
+
+    out.deviceSwitchGlitch = s.deviceSwitchGlitch;
+    return out;
+}
+
 static PPayloadInfo exportPayloadInfo(const PayloadInfo &p)
 {
     PPayloadInfo out;
@@ -432,12 +479,60 @@ const QList<VideoParams> &Features::supportedVideoModes() { return d->supportedV
 //----------------------------------------------------------------------------
 class RtpPacket::Private : public QSharedData {
 public:
-    QByteArray rawValue;
-    int        portOffset;
+    QByteArray            rawValue;
+    int                   portOffset;
+    qint64                timestamp = -1;
+    std::shared_ptr<void> storage;
 
     Private(const QByteArray &_rawValue, int _portOffset) : rawValue(_rawValue), portOffset(_portOffset) { }
+
+    // one of these is created and dropped per packet, so the memory is
+    //   recycled rather than returned to the heap
+    static void *operator new(size_t size);
+    static void  operator delete(void *p);
+};
+
+#define RTPPACKET_FREE_MAX 1024
+
+class RtpPacketFreeList {
+public:
+    QMutex              mutex;
+    std::vector<void *> blocks;
+
+    RtpPacketFreeList() { blocks.reserve(RTPPACKET_FREE_MAX); }
+
+    // never destroyed, packets may outlive static destruction
+    static RtpPacketFreeList *instance()
+    {
+        static auto list = new RtpPacketFreeList;
+        return list;
+    }
 };
 
+void *RtpPacket::Private::operator new(size_t size)
+{
+    RtpPacketFreeList *list = RtpPacketFreeList::instance();
+    {
+        QMutexLocker locker(&list->mutex);
+        if (!list->blocks.empty()) {
+            void *p = list->blocks.back();
+            list->blocks.pop_back();
+            return p;
+        }
+    }
+    return ::operator new(size);
+}
+
+void RtpPacket::Private::operator delete(void *p)
+{
+    RtpPacketFreeList *list = RtpPacketFreeList::instance();
+    QMutexLocker       locker(&list->mutex);
+    if (list->blocks.size() < RTPPACKET_FREE_MAX)
+        list->blocks.push_back(p);
+    else
+        ::operator delete(p);
+}
+
 RtpPacket::RtpPacket() : d(nullptr) { }
 
 RtpPacket::RtpPacket(const QByteArray &rawValue, int portOffset) : d(new Private(rawValue, portOffset)) { }
@@ -454,9 +549,33 @@ QByteArray RtpPacket::rawValue() const { return d->rawValue; }
 
 int RtpPacket::portOffset() const { return d->portOffset; }
 
+qint64 RtpPacket::timestamp() const { return d->timestamp; }
+
+void RtpPacket::setTimestamp(qint64 usecs) { d->timestamp = usecs; }
+
+qint64 RtpPacket::currentTime() { return PRtpPacket::currentTime(); }
+
 //----------------------------------------------------------------------------
 // RtpChannel
 //----------------------------------------------------------------------------
+// packets referencing provider memory are only handed out as they are
+//   when the application opted into zero-copy with PSI_RTP_ZERO_COPY.
+//   otherwise they get their own copy of the bytes
+static bool use_zero_copy_reads()
+{
+    static const bool on = !qgetenv("PSI_RTP_ZERO_COPY").isEmpty();
+    return on;
+}
+
+// the bytes of the packet as the application gets them, copied unless
+//   they are owned by the array or zero-copy was asked for
+static QByteArray import_raw_value(const PRtpPacket &pp)
+{
+    if (pp.storage && !use_zero_copy_reads())
+        return QByteArray(pp.rawValue.constData(), pp.rawValue.size());
+    return pp.rawValue;
+}
+
 RtpChannel::RtpChannel() { d = new RtpChannelPrivate(this); }
 
 RtpChannel::~RtpChannel() { delete d; }
@@ -473,7 +592,11 @@ RtpPacket RtpChannel::read()
 {
     if (d->c) {
         PRtpPacket pp = d->c->read();
-        return RtpPacket(pp.rawValue, pp.portOffset);
+        RtpPacket  rtp(import_raw_value(pp), pp.portOffset);
+        rtp.d->timestamp = pp.timestamp;
+        if (use_zero_copy_reads())
+            rtp.d->storage = pp.storage;
+        return rtp;
     } else
         return RtpPacket();
 }
@@ -489,10 +612,78 @@ void RtpChannel::write(const RtpPacket &rtp)
         PRtpPacket pp;
         pp.rawValue   = rtp.rawValue();
         pp.portOffset = rtp.portOffset();
+        pp.timestamp  = rtp.timestamp() >= 0 ? rtp.timestamp() : RtpPacket::currentTime();
+        pp.storage    = rtp.d->storage;
         d->c->write(pp);
     }
 }
 
+QVector<RtpPacket> RtpChannel::readAll()
+{
+    QVector<RtpPacket> ret;
+    if (d->c) {
+        const QVector<PRtpPacket> list = d->c->readAll();
+        ret.reserve(list.count());
+        for (const PRtpPacket &pp : list) {
+            RtpPacket rtp(import_raw_value(pp), pp.portOffset);
+            rtp.d->timestamp = pp.timestamp;
+            if (use_zero_copy_reads())
+                rtp.d->storage = pp.storage;
+            ret += rtp;
+        }
+    }
+    return ret;
+}
+
+void RtpChannel::writeBatch(const QVector<RtpPacket> &packets)
+{
+    if (d->c) {
+        if (!d->enabled) {
+            d->enabled = true;
+            d->c->setEnabled(true);
+        }
+
+        // packets without a timestamp are taken to arrive now
+        QVector<PRtpPacket> list;
+        qint64              now = RtpPacket::currentTime();
+        list.reserve(packets.count());
+        for (const RtpPacket &rtp : packets) {
+            PRtpPacket pp;
+            pp.rawValue   = rtp.rawValue();
+            pp.portOffset = rtp.portOffset();
+            pp.timestamp  = rtp.timestamp() >= 0 ? rtp.timestamp() : now;
+            pp.storage    = rtp.d->storage;
+            list += pp;
+        }
+        d->c->writeBatch(list);
+    }
+}
+
+void RtpChannel::setQueueLimits(int capacity, int wakePackets, int wakeIntervalMs)
+{
+    d->queueCapacity  = capacity;
+    d->wakePackets    = wakePackets;
+    d->wakeIntervalMs = wakeIntervalMs;
+    if (d->c)
+        d->c->setQueueLimits(capacity, wakePackets, wakeIntervalMs);
+}
+
+RtpChannelStats RtpChannel::stats() const
+{
+    RtpChannelStats ret;
+    if (d->c) {
+        PRtpChannelStats s = d->c->stats();
+        ret.packetsQueued   = s.packetsQueued;
+        ret.packetsDropped  = s.packetsDropped;
+        ret.overflows       = s.overflows;
+        ret.batchOverflows  = s.batchOverflows;
+        ret.maxQueued       = s.maxQueued;
+        ret.pipelineLatency = importRtpLatency(s.pipelineLatency);
+        ret.queueLatency    = importRtpLatency(s.queueLatency);
+    }
+    return ret;
+}
+
 void RtpChannel::connectNotify(const QMetaMethod &signal)
 {
     int oldtotal = d->readyReadListeners;
@@ -671,6 +862,10 @@ void RtpSession::setLocalVideoPreferences(const QList<VideoParams> &params)
 
 void RtpSession::setMaximumSendingBitrate(int kbps) { d->c->setMaximumSendingBitrate(kbps); }
 
+void RtpSession::setRealtimeVideoEncoding(bool enabled) { d->c->setRealtimeVideoEncoding(enabled); }
+
+void RtpSession::setOpusOptions(const OpusOptions &options) { d->c->setOpusOptions(exportOpusOptions(options)); }
+
 void RtpSession::setRemoteAudioPreferences(const QList<PayloadInfo> &info)
 {
     QList<PPayloadInfo> list;
@@ -699,6 +894,10 @@ void RtpSession::pauseAudio() { d->c->pauseAudio(); }
 
 void RtpSession::pauseVideo() { d->c->pauseVideo(); }
 
+void RtpSession::hold() { d->c->hold(); }
+
+void RtpSession::resume() { d->c->resume(); }
+
 void RtpSession::stop() { d->c->stop(); }
 
 QList<PayloadInfo> RtpSession::localAudioPayloadInfo() const
@@ -766,4 +965,39 @@ RtpSession::Error RtpSession::errorCode() const { return static_cast<RtpSession:
 RtpChannel *RtpSession::audioRtpChannel() { return &d->audioRtpChannel; }
 
 RtpChannel *RtpSession::videoRtpChannel() { return &d->videoRtpChannel; }
+
+void RtpSession::setAudioConference(bool enabled) { d->c->setAudioConference(enabled); }
+
+void RtpSession::setParticipantVolume(quint32 ssrc, int level) { d->c->setParticipantVolume(ssrc, level); }
+
+void RtpSession::setParticipantMuted(quint32 ssrc, bool muted) { d->c->setParticipantMuted(ssrc, muted); }
+
+void RtpSession::addForwardTarget(RtpSession *target) { d->c->addForwardTarget(target->d->c); }
+
+void RtpSession::removeForwardTarget(RtpSession *target) { d->c->removeForwardTarget(target->d->c); }
+
+RtpSessionStats RtpSession::statistics() const
+{
+    PRtpSessionStats s = d->c->statistics();
+    RtpSessionStats  out;
+    out.audioOut = importRtpStreamStats(s.audioOut);
+    out.audioIn  = importRtpStreamStats(s.audioIn);
+    out.videoOut = importRtpStreamStats(s.videoOut);
+    out.videoIn  = importRtpStreamStats(s.videoIn);
+
+    out.timeToStarted = s.timeToStarted;
+    out.avOffset      = s.avOffset;
+    out.haveAvOffset  = s.haveAvOffset;
+    return out;
+}
+
+void RtpSession::setAudioUdpTransport(const UdpTransport &transport)
+{
+    d->c->setAudioUdpTransport(exportUdpTransport(transport));
+}
+
+void RtpSession::setVideoUdpTransport(const UdpTransport &transport)
+{
+    d->c->setVideoUdpTransport(exportUdpTransport(transport));
+}
 }; // namespace PsiMedia
@@ -25,6 +25,7 @@
 #include <QSharedDataPointer>
 #include <QSize>
 #include <QStringList>
+#include <QVector>
 #ifdef QT_GUI_LIB
 #include <QWidget>
 #endif
@@ -186,24 +187,132 @@ public:
 
     bool isNull() const;
 
+    // with PSI_RTP_ZERO_COPY set, packets read from an RtpChannel may
+    //   reference provider memory directly. the returned array is then
+    //   only valid while this packet (or a copy of it) is alive, and has
+    //   to be copied to be kept longer. without it the array owns its
+    //   bytes like any other
     QByteArray rawValue() const;
     int        portOffset() const;
 
+    // microseconds on the clock of currentTime(), or -1. packets read
+    //   from an RtpChannel carry the time their media was captured. for
+    //   packets written, this is the arrival time and is filled in with
+    //   the time of the write if not set
+    qint64 timestamp() const;
+    void   setTimestamp(qint64 usecs);
+
+    static qint64 currentTime();
+
 private:
     class Private;
+    friend class RtpChannel;
     QSharedDataPointer<Private> d;
 };
 
+// microseconds spent in one stage, over all timestamped packets
+class RtpLatencyStats {
+public:
+    quint64 count = 0;
+    qint64  total = 0;
+    qint64  max   = 0;
+
+    inline qint64 average() const { return count ? total / qint64(count) : 0; }
+};
+
+class RtpChannelStats {
+public:
+    quint64 packetsQueued  = 0; // packets that entered the read queue
+    quint64 packetsDropped = 0; // packets bumped off the read queue unread
+    quint64 overflows      = 0; // times the read queue filled up
+    quint64 batchOverflows = 0; // batches larger than the read queue, which grew to fit them
+    int     maxQueued      = 0; // high-water mark of the read queue
+
+    RtpLatencyStats pipelineLatency; // capture to the read queue
+    RtpLatencyStats queueLatency;    // read queue to the application
+};
+
+// rtcp derived figures for one direction of one media
+class RtpStreamStats {
+public:
+    quint32 ssrc          = 0;  // 0 until the stream has been seen
+    quint64 packets       = 0;  // sent or received
+    qint64  packetsLost   = 0;  // cumulative
+    double  fractionLost  = 0;  // over the last interval, 0.0 - 1.0
+    int     jitter        = -1; // ms, -1 if unknown
+    int     roundTripTime = -1; // ms, outgoing streams only
+
+    // ms of silence or frozen video caused by the last switch of the local
+    //   device feeding or playing this stream, -1 if there was none
+    int deviceSwitchGlitch = -1;
+};
+
+// for outgoing streams the figures are what the peer reported back in
+//   its receiver reports
+class RtpSessionStats {
+public:
+    RtpStreamStats audioOut;
+    RtpStreamStats audioIn;
+    RtpStreamStats videoOut;
+    RtpStreamStats videoIn;
+
+    int timeToStarted = -1; // ms from start() until started()
+
+    // ms by which received video plays behind the audio captured at the
+    //   same time (ahead if negative). needs sender reports for both
+    int  avOffset     = 0;
+    bool haveAvOffset = false;
+};
+
+// opus encoder settings. fec also makes the decoder recover lost frames
+//   from the redundancy the peer sends
+class OpusOptions {
+public:
+    int  bitrate      = -1; // kbps, -1 keeps the encoder's default
+    int  frameSize    = -1; // ms, -1 follows the remote ptime (or 20)
+    bool inbandFec    = false;
+    int  expectedLoss = -1; // percent, how much redundancy fec carries. -1 is 10, 0 makes fec carry none
+    bool dtx          = false;
+    int  complexity   = -1; // 0 to 10, -1 keeps the encoder's default
+};
+
+// udp endpoints for a media when the provider is asked to do the
+//   networking itself. rtp uses the base port and rtcp the one above it
+class UdpTransport {
+public:
+    QString localAddress;        // empty binds to any
+    int     localBasePort  = -1; // -1 picks ephemeral ports
+    QString remoteAddress;       // empty means receive only
+    int     remoteBasePort = -1;
+};
+
 // may drop packets if not read fast enough.
 // may queue no packets at all, if nobody is listening to readyRead.
 class RtpChannel : public QObject {
     Q_OBJECT
 
 public:
+    // packets read own their bytes, unless PSI_RTP_ZERO_COPY is set (see
+    //   RtpPacket::rawValue())
     int       packetsAvailable() const;
     RtpPacket read();
     void      write(const RtpPacket &rtp);
 
+    // same as calling read() until nothing is left, or write() for each
+    //   packet, but cheaper
+    QVector<RtpPacket> readAll();
+    void               writeBatch(const QVector<RtpPacket> &packets);
+
+    // by default up to 25 packets are queued and readyRead is emitted for
+    //   every packet. with a non-zero wakeIntervalMs, readyRead waits until
+    //   wakePackets packets are queued or the interval passes, trading
+    //   latency for fewer wakeups. can be called before the session starts.
+    //   outgoing video arrives a frame at a time, and a frame larger than
+    //   the queue makes it grow rather than lose the start of the frame.
+    //   that is counted in RtpChannelStats::batchOverflows
+    void            setQueueLimits(int capacity, int wakePackets = 1, int wakeIntervalMs = 0);
+    RtpChannelStats stats() const;
+
 signals:
     void readyRead();
     void packetsWritten(int count);
@@ -281,6 +390,8 @@ public:
 
     void reset();
 
+    // devices can be changed while the session runs. they are switched
+    //   over without restarting it
     void setAudioOutputDevice(const QString &deviceId);
 #ifdef QT_GUI_LIB
     void setVideoOutputWidget(VideoWidget *widget);
@@ -311,6 +422,14 @@ public:
 
     void setMaximumSendingBitrate(int kbps);
 
+    // tune the video encoder for low latency at the sending size and the
+    //   cores available. this is the default, turning it off leaves the
+    //   encoder's own defaults, which favor quality over speed
+    void setRealtimeVideoEncoding(bool enabled);
+
+    // read when the audio elements are built, so set it before start()
+    void setOpusOptions(const OpusOptions &options);
+
     // set remote preferences, using payloadinfo.
     void setRemoteAudioPreferences(const QList<PayloadInfo> &info);
     void setRemoteVideoPreferences(const QList<PayloadInfo> &info);
@@ -404,6 +523,15 @@ public:
     void pauseVideo();
     void stop();
 
+    // call hold: the capture and playback devices are released and the
+    //   media pipelines go idle, so a held session costs next to nothing.
+    //   codecs, payload types and ssrcs stay as they are, so resume()
+    //   needs no renegotiation. transmit/pause state is kept across a
+    //   hold. device and preference changes made while held take effect
+    //   on resume. has no effect on file input
+    void hold();
+    void resume();
+
     // in a correctly negotiated session, there will be an equal amount of
     //   local/remote values for each media type (during negotiation there
     //   may be a mismatch).  however, the payloadinfo for each won't
@@ -440,11 +568,37 @@ public:
     int  inputVolume() const; // 0 (mute) to 100
     void setInputVolume(int level);
 
+    // conference mode, must be enabled before start(). every remote
+    //   participant (ssrc) on the audio channel is decoded separately and
+    //   they are mixed into one playback stream, with a gain and mute of
+    //   their own
+    void setAudioConference(bool enabled);
+    void setParticipantVolume(quint32 ssrc, int level); // 0 (mute) to 100
+    void setParticipantMuted(quint32 ssrc, bool muted);
+
+    // forwarding mode. the rtp this session receives is relayed as-is,
+    //   apart from ssrc and sequence numbers, to the egress of each target
+    //   session. nothing is decoded, so a session that only forwards
+    //   doesn't need to be started. a late joining target gets the last
+    //   video keyframe first
+    void addForwardTarget(RtpSession *target);
+    void removeForwardTarget(RtpSession *target);
+
     Error errorCode() const;
 
     RtpChannel *audioRtpChannel();
     RtpChannel *videoRtpChannel();
 
+    // let the provider send and receive the media over udp itself, on its
+    //   own i/o thread, instead of going through the RtpChannel. must be
+    //   called before start(). the corresponding channel stays silent
+    void setAudioUdpTransport(const UdpTransport &transport);
+    void setVideoUdpTransport(const UdpTransport &transport);
+
+    // rtcp statistics, refreshed about once a second while running.
+    //   statisticsUpdated() is emitted on every refresh
+    RtpSessionStats statistics() const;
+
 signals:
     void started();
     void preferencesUpdated();
@@ -454,6 +608,7 @@ signals:
     void stopped();
     void finished(); // for file playback only
     void error();
+    void statisticsUpdated();
 
 private:
     Q_DISABLE_COPY(RtpSession)
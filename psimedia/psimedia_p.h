@@ -131,6 +131,9 @@ public:
     RtpChannelContext *c;
     bool               enabled;
     int                readyReadListeners;
+    int                queueCapacity  = -1;
+    int                wakePackets    = 1;
+    int                wakeIntervalMs = 0;
 
     RtpChannelPrivate(RtpChannel *_q) : QObject(_q), q(_q), c(nullptr), enabled(false), readyReadListeners(0) { }
 
@@ -152,6 +155,9 @@ public:
         connect(c->qobject(), SIGNAL(packetsWritten(int)), SLOT(c_packetsWritten(int)));
         connect(c->qobject(), SIGNAL(destroyed()), SLOT(c_destroyed()));
 
+        if (queueCapacity > 0)
+            c->setQueueLimits(queueCapacity, wakePackets, wakeIntervalMs);
+
         if (readyReadListeners > 0) {
             enabled = true;
             c->setEnabled(true);
@@ -194,6 +200,7 @@ public:
         connect(c->qobject(), SIGNAL(stopped()), SLOT(c_stopped()));
         connect(c->qobject(), SIGNAL(finished()), SLOT(c_finished()));
         connect(c->qobject(), SIGNAL(error()), SLOT(c_error()));
+        connect(c->qobject(), SIGNAL(statisticsUpdated()), SLOT(c_statisticsUpdated()));
     }
 
     ~RtpSessionPrivate() { delete c; }
@@ -214,6 +221,8 @@ private slots:
 
     void c_stoppedRecording() { emit q->stoppedRecording(); }
 
+    void c_statisticsUpdated() { emit q->statisticsUpdated(); }
+
     void c_stopped()
     {
         audioRtpChannel.d->setContext(nullptr);
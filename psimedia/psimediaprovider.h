@@ -28,8 +28,11 @@
 #include <QSize>
 #include <QString>
 #include <QVariantMap>
+#include <QVector>
 
+#include <chrono>
 #include <functional>
+#include <memory>
 
 // since we cannot put signals/slots in Qt "interfaces", we use the following
 //   defines to hint about signals/slots that derived classes should provide
@@ -150,7 +153,106 @@ public:
     QByteArray rawValue;
     int        portOffset;
 
-    inline PRtpPacket() : portOffset(0) { }
+    // when set, rawValue doesn't own its bytes (see QByteArray::fromRawData)
+    //   and they stay valid only as long as this reference is held
+    std::shared_ptr<void> storage;
+
+    // microseconds on the monotonic clock of currentTime(), -1 if unknown.
+    //   outgoing packets carry the capture time of their media, incoming
+    //   ones the time they arrived
+    qint64 timestamp;
+
+    inline PRtpPacket() : portOffset(0), timestamp(-1) { }
+
+    static inline qint64 currentTime()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+};
+
+// microseconds spent in one stage, over all timestamped packets
+class PRtpLatency {
+public:
+    quint64 count = 0;
+    qint64  total = 0;
+    qint64  max   = 0;
+
+    inline void add(qint64 usecs)
+    {
+        ++count;
+        total += usecs;
+        max = qMax(max, usecs);
+    }
+};
+
+class PRtpChannelStats {
+public:
+    quint64 packetsQueued  = 0; // packets that entered the read queue
+    quint64 packetsDropped = 0; // packets bumped off the read queue unread
+    quint64 overflows      = 0; // times the read queue filled up
+    quint64 batchOverflows = 0; // batches larger than the read queue, which grew to fit them
+    int     maxQueued      = 0; // high-water mark of the read queue
+
+    PRtpLatency pipelineLatency; // capture to the read queue
+    PRtpLatency queueLatency;    // read queue to the application
+};
+
+// rtcp derived figures for one direction of one media
+class PRtpStreamStats {
+public:
+    quint32 ssrc          = 0;  // 0 until the stream has been seen
+    quint64 packets       = 0;  // sent or received
+    qint64  packetsLost   = 0;  // cumulative
+    double  fractionLost  = 0;  // over the last interval, 0.0 - 1.0
+    int     jitter        = -1; // ms, -1 if unknown
+    int     roundTripTime = -1; // ms, outgoing streams only
+
+    // ms of silence or frozen video caused by the last switch of the local
+    //   device feeding or playing this stream, -1 if there was none
+    int deviceSwitchGlitch = -1;
+};
+
+class PRtpSessionStats {
+public:
+    PRtpStreamStats audioOut;
+    PRtpStreamStats audioIn;
+    PRtpStreamStats videoOut;
+    PRtpStreamStats videoIn;
+
+    int timeToStarted = -1; // ms from start() until started()
+
+    // ms by which received video plays behind the audio captured at the
+    //   same time (ahead if negative). needs sender reports for both
+    int  avOffset     = 0;
+    bool haveAvOffset = false;
+};
+
+// udp endpoints for a channel when the provider does the networking itself.
+//   rtp uses the base port and rtcp the one above it
+class PUdpTransport {
+public:
+    QString localAddress;        // empty binds to any
+    int     localBasePort  = -1; // -1 picks ephemeral ports
+    QString remoteAddress;       // empty means receive only
+    int     remoteBasePort = -1;
+
+    inline bool isNull() const { return localBasePort == -1 && remoteAddress.isEmpty(); }
+};
+
+// libopus sends no fec at all for 0% expected loss, so that is what is
+//   assumed when fec is on and nothing else was asked for
+#define OPUS_FEC_LOSS 10
+
+class POpusOptions {
+public:
+    int  bitrate      = -1; // kbps, -1 keeps the encoder's default
+    int  frameSize    = -1; // ms, -1 follows the remote ptime
+    bool inbandFec    = false;
+    int  expectedLoss = -1; // percent, sizes the fec. -1 is OPUS_FEC_LOSS
+    bool dtx          = false;
+    int  complexity   = -1; // 0 to 10, -1 keeps the encoder's default
 };
 
 class Provider : public QObjectInterface {
@@ -183,6 +285,17 @@ public:
     virtual PRtpPacket read()                       = 0;
     virtual void       write(const PRtpPacket &rtp) = 0;
 
+    // batch variants. readAll() returns everything queued so far, and
+    //   writeBatch() results in a single packetsWritten() for the batch
+    virtual QVector<PRtpPacket> readAll()                                  = 0;
+    virtual void                writeBatch(const QVector<PRtpPacket> &rtp) = 0;
+
+    // capacity of the read queue, and how many packets to collect (waiting
+    //   at most wakeIntervalMs) before waking the reader. an interval of 0
+    //   wakes the reader for every packet
+    virtual void             setQueueLimits(int capacity, int wakePackets, int wakeIntervalMs) = 0;
+    virtual PRtpChannelStats stats() const                                                      = 0;
+
     HINT_SIGNALS : HINT_METHOD(readyRead()) HINT_METHOD(packetsWritten(int count))
 };
 
@@ -225,6 +338,13 @@ public:
 
     virtual void setMaximumSendingBitrate(int kbps) = 0;
 
+    // on by default. off leaves the video encoder on its own defaults
+    //   apart from the bitrate
+    virtual void setRealtimeVideoEncoding(bool enabled) = 0;
+
+    // read when the opus elements are built, so set before start()
+    virtual void setOpusOptions(const POpusOptions &options) = 0;
+
     virtual void setRemoteAudioPreferences(const QList<PPayloadInfo> &info) = 0;
     virtual void setRemoteVideoPreferences(const QList<PPayloadInfo> &info) = 0;
 
@@ -238,6 +358,11 @@ public:
     virtual void pauseVideo() = 0;
     virtual void stop()       = 0;
 
+    // hold releases the devices and idles the pipelines, without touching
+    //   the negotiated payloads. resume picks up where hold left off
+    virtual void hold()   = 0;
+    virtual void resume() = 0;
+
     virtual QList<PPayloadInfo> localAudioPayloadInfo() const  = 0;
     virtual QList<PPayloadInfo> localVideoPayloadInfo() const  = 0;
     virtual QList<PPayloadInfo> remoteAudioPayloadInfo() const = 0;
@@ -255,18 +380,39 @@ public:
     virtual int  inputVolume() const       = 0; // 0 (mute) to 100
     virtual void setInputVolume(int level) = 0;
 
+    // conference mode must be set before start(). each remote ssrc on the
+    //   audio channel is then decoded separately and mixed for playback
+    virtual void setAudioConference(bool enabled)              = 0;
+    virtual void setParticipantVolume(quint32 ssrc, int level) = 0; // 0 (mute) to 100
+    virtual void setParticipantMuted(quint32 ssrc, bool muted) = 0;
+
+    // forwarding: rtp written to this session's channels (or received by
+    //   its udp transports) is also sent out of the target's, with the
+    //   target's own ssrc and sequence numbers and without decoding. the
+    //   target must come from the same provider
+    virtual void addForwardTarget(RtpSessionContext *target)    = 0;
+    virtual void removeForwardTarget(RtpSessionContext *target) = 0;
+
     virtual Error errorCode() const = 0;
 
     virtual RtpChannelContext *audioRtpChannel() = 0;
     virtual RtpChannelContext *videoRtpChannel() = 0;
 
+    // must be set before start(). a non-null transport makes the provider
+    //   own the sockets for that media, and its channel carries no packets
+    virtual void setAudioUdpTransport(const PUdpTransport &transport) = 0;
+    virtual void setVideoUdpTransport(const PUdpTransport &transport) = 0;
+
+    // latest rtcp statistics, refreshed about once a second
+    virtual PRtpSessionStats statistics() const = 0;
+
     virtual void dumpPipeline(std::function<void(const QStringList &)> callback) = 0;
 
     HINT_SIGNALS : HINT_METHOD(started()) HINT_METHOD(preferencesUpdated())
                        HINT_METHOD(audioOutputIntensityChanged(int intensity))
                            HINT_METHOD(audioInputIntensityChanged(int intensity)) HINT_METHOD(stoppedRecording())
                                HINT_METHOD(stopped()) HINT_METHOD(finished()) // for file playback only
-                   HINT_METHOD(error())
+                   HINT_METHOD(error()) HINT_METHOD(statisticsUpdated())
 };
 
 class AudioRecorderContext : public QObjectInterface {
@@ -294,8 +440,8 @@ public:
 Q_DECLARE_INTERFACE(PsiMedia::Plugin, "org.psi-im.psimedia.Plugin/1.6")
 Q_DECLARE_INTERFACE(PsiMedia::Provider, "org.psi-im.psimedia.Provider/1.6")
 Q_DECLARE_INTERFACE(PsiMedia::FeaturesContext, "org.psi-im.psimedia.FeaturesContext/1.6")
-Q_DECLARE_INTERFACE(PsiMedia::RtpChannelContext, "org.psi-im.psimedia.RtpChannelContext/1.6")
-Q_DECLARE_INTERFACE(PsiMedia::RtpSessionContext, "org.psi-im.psimedia.RtpSessionContext/1.6")
+Q_DECLARE_INTERFACE(PsiMedia::RtpChannelContext, "org.psi-im.psimedia.RtpChannelContext/1.7")
+Q_DECLARE_INTERFACE(PsiMedia::RtpSessionContext, "org.psi-im.psimedia.RtpSessionContext/1.7")
 Q_DECLARE_INTERFACE(PsiMedia::AudioRecorderContext, "org.psi-im.psimedia.AudioRecorderContext/1.4")
 
 #endif // PSIMEDIAPROVIDER_H
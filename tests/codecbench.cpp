@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// what each installed video codec costs to send: cpu time per frame and
+//   bits per frame at the same target bitrate, on the same moving test
+//   pattern, at 480p and 720p. vp8 is run with and without the realtime
+//   profile. the cost of making the pattern is measured alone first and
+//   taken off
+
+#include "bins.h"
+#include "codecs.h"
+#include "harness.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QSize>
+#include <cstdio>
+#include <gst/gst.h>
+
+using namespace PsiMedia;
+
+class Run {
+public:
+    qint64  cpu   = 0; // ms
+    quint64 bytes = 0;
+    bool    ok    = false;
+};
+
+static void cb_handoff(GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer app)
+{
+    Q_UNUSED(sink)
+    Q_UNUSED(pad)
+    static_cast<Run *>(app)->bytes += gst_buffer_get_size(buffer);
+}
+
+// pushes frames of the test pattern through encbin as fast as it goes.
+//   without encbin only the pattern is made
+static Run encode(GstElement *encbin, const QSize &size, int frames)
+{
+    Run         run;
+    GstElement *pipeline = gst_pipeline_new(nullptr);
+    GstElement *src      = gst_element_factory_make("videotestsrc", nullptr);
+    GstElement *filter   = gst_element_factory_make("capsfilter", nullptr);
+    GstElement *sink     = gst_element_factory_make("fakesink", nullptr);
+    g_object_set(G_OBJECT(src), "num-buffers", frames, nullptr);
+    gst_util_set_object_arg(G_OBJECT(src), "pattern", "ball");
+    g_object_set(G_OBJECT(sink), "sync", FALSE, "signal-handoffs", TRUE, nullptr);
+    g_signal_connect(G_OBJECT(sink), "handoff", G_CALLBACK(cb_handoff), &run);
+
+    GstCaps *caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING, "I420", "width", G_TYPE_INT,
+                                        size.width(), "height", G_TYPE_INT, size.height(), "framerate",
+                                        GST_TYPE_FRACTION, 30, 1, nullptr);
+    g_object_set(G_OBJECT(filter), "caps", caps, nullptr);
+    gst_caps_unref(caps);
+
+    gst_bin_add_many(GST_BIN(pipeline), src, filter, sink, nullptr);
+    if (encbin) {
+        gst_bin_add(GST_BIN(pipeline), encbin);
+        gst_element_link_many(src, filter, encbin, sink, nullptr);
+    } else
+        gst_element_link_many(src, filter, sink, nullptr);
+
+    qint64 cpu = Test::cpuTime();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus     *bus = gst_element_get_bus(pipeline);
+    GstMessage *msg = gst_bus_timed_pop_filtered(bus, 120 * GST_SECOND,
+                                                 GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+    run.cpu = Test::cpuTime() - cpu;
+    run.ok  = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+    if (msg)
+        gst_message_unref(msg);
+    gst_object_unref(bus);
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return run;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "frames", "Frames to encode per run.", "count", "150" });
+    parser.addOption({ "kbps", "Target bitrate of every codec.", "kbps", "1000" });
+    parser.process(app);
+
+    int frames = qMax(parser.value("frames").toInt(), 1);
+    int kbps   = parser.value("kbps").toInt();
+
+    gst_init(nullptr, nullptr);
+    codecs_probe();
+
+    bool ok = true;
+    printf("%-6s %-9s %-8s %10s %12s\n", "codec", "size", "profile", "ms/frame", "kbit/frame");
+    for (const QSize &size : { QSize(640, 480), QSize(1280, 720) }) {
+        Run base = encode(nullptr, size, frames);
+        if (!base.ok) {
+            printf("videotestsrc failed\n");
+            return 1;
+        }
+
+        for (const CodecDesc *desc : codecs_available(CodecDesc::Video)) {
+            QString codec = QString::fromLatin1(desc->name);
+            for (bool realtime : { true, false }) {
+                // only vp8 has a realtime profile of its own
+                if (!realtime && codec != "vp8")
+                    continue;
+
+                GstElement *encbin = bins_videoenc_create(codec, -1, kbps, size, realtime);
+                Run         run    = encbin ? encode(encbin, size, frames) : Run();
+                if (!run.ok) {
+                    printf("%-6s %4dx%-4d failed\n", desc->name, size.width(), size.height());
+                    ok = false;
+                    continue;
+                }
+
+                double msPerFrame   = double(qMax(run.cpu - base.cpu, qint64(0))) / frames;
+                double kbitPerFrame = double(run.bytes) * 8 / 1000 / frames;
+                printf("%-6s %4dx%-4d %-8s %10.2f %12.1f\n", desc->name, size.width(), size.height(),
+                       realtime ? "realtime" : "default", msPerFrame, kbitPerFrame);
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// one conference receiver mixing the audio of N senders. every call has
+//   to work. the cpu time of the whole call, per participant, is only
+//   reported, since it depends on the machine and on how busy it is
+
+#include "gstprovider.h"
+#include "harness.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstdio>
+
+using namespace PsiMedia;
+
+// cpu ms per second of call, or -1 if the call didn't work
+static double measure(Provider *provider, int participants, int seconds)
+{
+    TestCall::Options options;
+    options.senders    = participants;
+    options.conference = true;
+
+    TestCall call(provider, options);
+    call.start();
+    bool ok = Test::waitFor([&]() { return call.isStarted() || call.hasError(); }, 30000) && call.isStarted();
+
+    double cpuPerSecond = -1;
+    if (ok) {
+        // let the jitter buffers fill and the mixer get going
+        Test::run(1000);
+        quint64 relayed = call.audioRelayed;
+        qint64  cpu     = Test::cpuTime();
+        Test::run(seconds * 1000);
+        cpu = Test::cpuTime() - cpu;
+        if (!call.hasError() && call.audioRelayed > relayed)
+            cpuPerSecond = double(cpu) / seconds;
+    }
+
+    call.stop();
+    Test::waitFor([&]() { return call.isStopped(); }, 10000);
+    return cpuPerSecond;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "participants", "Largest number of senders to mix.", "count", "8" });
+    parser.addOption({ "seconds", "How long each call is measured.", "seconds", "3" });
+    parser.process(app);
+
+    int  maxParticipants = qMax(parser.value("participants").toInt(), 1);
+    int  seconds         = qMax(parser.value("seconds").toInt(), 1);
+    auto provider        = Test::createProvider();
+    if (!provider)
+        return 1;
+
+    bool   ok    = true;
+    double first = -1;
+    double last  = -1;
+    printf("%12s %14s %16s\n", "participants", "cpu ms/s", "per participant");
+    for (int n = 1; n <= maxParticipants; n *= 2) {
+        double cpu = measure(provider, n, seconds);
+        if (cpu < 0) {
+            printf("%12d failed\n", n);
+            ok = false;
+            break;
+        }
+        printf("%12d %14.1f %16.1f\n", n, cpu, cpu / n);
+        if (first < 0)
+            first = cpu / n;
+        last = cpu / n;
+    }
+
+    // receiving, decoding and mixing a participant shouldn't get dearer
+    //   with more of them
+    if (ok && first > 0)
+        printf("cost per participant, most against fewest: %.2fx\n", last / first);
+
+    delete provider;
+    return ok ? 0 : 1;
+}
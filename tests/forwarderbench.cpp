@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// the forwarder has to find keyframes in every video codec it knows, so
+//   a late target catches up from the last keyframe without missing a
+//   reference, and pass anything else straight through. then how many
+//   streams one core can forward, which is reported but not checked
+
+#include "harness.h"
+#include "rtpforwarder.h"
+#include "rtppacketpool.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstring>
+
+using namespace PsiMedia;
+
+#define PT_KNOWN 96
+#define PT_UNKNOWN 100
+
+// a video stream as the benchmark sends it: 30 frames a second of
+//   FRAME_PACKETS packets each
+#define FRAME_PACKETS 5
+#define STREAM_PPS (30 * FRAME_PACKETS)
+
+class Sink {
+public:
+    QVector<PRtpPacket> packets;
+
+    static void cb_packets(RtpForwarder::Media media, const QVector<PRtpPacket> &packets, void *app)
+    {
+        Q_UNUSED(media)
+        static_cast<Sink *>(app)->packets += packets;
+    }
+};
+
+// builds the rtp of a source stream, a frame at a time
+class Stream {
+public:
+    QString codec;
+    int     pt        = PT_KNOWN;
+    quint16 seq       = 0;
+    quint32 timestamp = 0;
+
+    QVector<PRtpPacket> frame(bool key, int count = FRAME_PACKETS)
+    {
+        QVector<PRtpPacket> out;
+        timestamp += 3000;
+        for (int n = 0; n < count; ++n) {
+            QByteArray payload = descriptor(key, n, count);
+            payload.append(1000, char(n));
+
+            char      *data   = nullptr;
+            PRtpPacket packet = RtpPacketPool::instance()->allocate(12 + int(payload.size()), &data);
+            auto       p      = reinterpret_cast<uchar *>(data);
+            p[0]              = 0x80;
+            p[1]              = uchar(pt | (n == count - 1 ? 0x80 : 0));
+            p[2]              = uchar(seq >> 8);
+            p[3]              = uchar(seq);
+            for (int i = 0; i < 4; ++i) {
+                p[4 + i] = uchar(timestamp >> (24 - i * 8));
+                p[8 + i] = uchar(0x12345678 >> (24 - i * 8));
+            }
+            memcpy(p + 12, payload.constData(), size_t(payload.size()));
+            ++seq;
+            out += packet;
+        }
+        return out;
+    }
+
+private:
+    QByteArray descriptor(bool key, int n, int count)
+    {
+        QByteArray d;
+        if (codec == "VP8") {
+            // S and partition 0, then the frame header P bit
+            d += char(n == 0 ? 0x10 : 0x00);
+            if (n == 0)
+                d += char(key ? 0x00 : 0x01);
+        } else if (codec == "H264") {
+            if (key && n == 0) {
+                // sps and pps aggregated in a stap-a, as zero-latency
+                //   aggregation sends them
+                d += char(24);
+                d += QByteArray::fromHex("000267420002");
+                d += QByteArray::fromHex("68ce");
+                return d;
+            }
+            // a fu-a of an idr or non-idr slice
+            d += char(0x7c);
+            d += char((key ? 5 : 1) | (n == (key ? 1 : 0) ? 0x80 : 0) | (n == count - 1 ? 0x40 : 0));
+        } else if (codec == "VP9") {
+            // B on the first packet, P on every packet of an inter frame
+            d += char((n == 0 ? 0x08 : 0) | (key ? 0 : 0x40));
+        } else if (codec == "AV1") {
+            // N on the first packet of a keyframe, one obu element
+            d += char(0x10 | (key && n == 0 ? 0x08 : 0) | (n > 0 ? 0x80 : 0));
+        } else {
+            d += char(n);
+        }
+        return d;
+    }
+};
+
+static int payloadByte(const PRtpPacket &packet, int at) { return uchar(packet.rawValue[12 + at]); }
+
+static quint16 packetSeq(const PRtpPacket &packet)
+{
+    return quint16((uchar(packet.rawValue[2]) << 8) | uchar(packet.rawValue[3]));
+}
+
+static bool checkCodec(const QString &codec)
+{
+    RtpForwarder        forwarder;
+    PPayloadInfo        pi;
+    QList<PPayloadInfo> info;
+    pi.id   = PT_KNOWN;
+    pi.name = codec;
+    info += pi;
+    forwarder.setVideoPayloadInfo(info);
+
+    Stream stream;
+    stream.codec = codec;
+
+    // a target with nothing to decode yet gets nothing
+    Sink early;
+    forwarder.addTarget(&early, Sink::cb_packets);
+    forwarder.forward(RtpForwarder::Video, stream.frame(false));
+    bool ok = early.packets.isEmpty();
+
+    // it goes live on the keyframe
+    QVector<PRtpPacket> key = stream.frame(true);
+    forwarder.forward(RtpForwarder::Video, key);
+    forwarder.forward(RtpForwarder::Video, stream.frame(false));
+    ok = ok && early.packets.count() == FRAME_PACKETS * 2;
+
+    // a late target joining mid-frame is sent everything since the
+    //   keyframe up to the live packet, in one unbroken sequence, and
+    //   then gets the rest of the frame live
+    Sink late;
+    forwarder.addTarget(&late, Sink::cb_packets);
+    QVector<PRtpPacket> inter = stream.frame(false);
+    forwarder.forward(RtpForwarder::Video, inter.mid(0, 2));
+    ok = ok && late.packets.count() == FRAME_PACKETS * 2 + 2;
+    forwarder.forward(RtpForwarder::Video, inter.mid(2));
+    forwarder.forward(RtpForwarder::Video, stream.frame(false));
+    ok = ok && late.packets.count() == FRAME_PACKETS * 4;
+    for (int n = 0; ok && n < FRAME_PACKETS; ++n)
+        ok = payloadByte(late.packets[n], 0) == payloadByte(key[n], 0);
+    for (int n = 1; ok && n < late.packets.count(); ++n)
+        ok = quint16(packetSeq(late.packets[n]) - packetSeq(late.packets[n - 1])) == 1;
+
+    // a new keyframe starts the group over
+    forwarder.forward(RtpForwarder::Video, stream.frame(true));
+    Sink later;
+    forwarder.addTarget(&later, Sink::cb_packets);
+    forwarder.forward(RtpForwarder::Video, stream.frame(false));
+    ok = ok && later.packets.count() == FRAME_PACKETS * 2;
+
+    printf("%-8s %s\n", qPrintable(codec), ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool checkPassthrough()
+{
+    RtpForwarder forwarder;
+    Stream       stream;
+    stream.codec = "VP8";
+    stream.pt    = PT_UNKNOWN;
+
+    // no payload info for it, so even vp8 can't be parsed. a target
+    //   starts right away
+    forwarder.forward(RtpForwarder::Video, stream.frame(true));
+    Sink sink;
+    forwarder.addTarget(&sink, Sink::cb_packets);
+    forwarder.forward(RtpForwarder::Video, stream.frame(false));
+    bool ok = sink.packets.count() == FRAME_PACKETS;
+    printf("%-8s %s\n", "unknown", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    bool ok = true;
+    for (const char *codec : { "VP8", "H264", "VP9", "AV1" })
+        ok &= checkCodec(codec);
+    ok &= checkPassthrough();
+
+    // one target per stream, as in a conference where each participant
+    //   gets everyone else's video
+    RtpForwarder        forwarder;
+    PPayloadInfo        pi;
+    QList<PPayloadInfo> info;
+    pi.id   = PT_KNOWN;
+    pi.name = "VP8";
+    info += pi;
+    forwarder.setVideoPayloadInfo(info);
+    Sink sink;
+    forwarder.addTarget(&sink, Sink::cb_packets);
+
+    Stream stream;
+    stream.codec = "VP8";
+    QVector<QVector<PRtpPacket>> frames;
+    for (int n = 0; n < 300; ++n)
+        frames += stream.frame(n % 150 == 0);
+
+    int           packets = 0;
+    qint64        cpu     = Test::cpuTime();
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 2000) {
+        for (const QVector<PRtpPacket> &frame : std::as_const(frames)) {
+            forwarder.forward(RtpForwarder::Video, frame);
+            packets += int(frame.count());
+        }
+        sink.packets.clear();
+    }
+    cpu = qMax(Test::cpuTime() - cpu, qint64(1));
+
+    double usPerPacket = cpu * 1000.0 / packets;
+    int    streams     = int(1000000.0 / (usPerPacket * STREAM_PPS));
+    printf("%.2f us/packet, %d streams of %d packets/s per core\n", usPerPacket, streams, STREAM_PPS);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#include "harness.h"
+
+#include "gstprovider.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSize>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace PsiMedia {
+
+namespace Test {
+
+    GstProvider *createProvider()
+    {
+        auto provider = new GstProvider;
+        if (!provider->isInitialized()) {
+            qWarning("gstreamer could not be initialized");
+            delete provider;
+            return nullptr;
+        }
+        return provider;
+    }
+
+    qint64 cpuTime()
+    {
+#ifdef Q_OS_WIN
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+            return 0;
+        auto ticks = [](const FILETIME &t) { return (qint64(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+        return (ticks(kernel) + ticks(user)) / 10000;
+#else
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        return qint64(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000
+            + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+#endif
+    }
+
+    bool waitFor(const std::function<bool()> &cond, int ms)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!cond()) {
+            if (timer.elapsed() >= ms)
+                return false;
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+            QThread::msleep(1);
+        }
+        return true;
+    }
+
+    void run(int ms)
+    {
+        waitFor([]() { return false; }, ms);
+    }
+
+}
+
+//----------------------------------------------------------------------------
+// TestCall
+//----------------------------------------------------------------------------
+static PAudioParams testAudioParams()
+{
+    PAudioParams p;
+    p.codec      = "opus";
+    p.sampleRate = 16000;
+    p.sampleSize = 16;
+    p.channels   = 1;
+    return p;
+}
+
+static PVideoParams testVideoParams()
+{
+    PVideoParams p;
+    p.codec = "vp8";
+    p.size  = QSize(640, 480);
+    p.fps   = 30;
+    return p;
+}
+
+TestCall::TestCall(Provider *provider, const Options &_options, QObject *parent) :
+    QObject(parent), options(_options)
+{
+    QList<PAudioParams> audioParams;
+    QList<PVideoParams> videoParams;
+    if (options.audio)
+        audioParams += testAudioParams();
+    if (options.video)
+        videoParams += testVideoParams();
+
+    for (int n = 0; n < options.senders; ++n) {
+        RtpSessionContext *s = provider->createRtpSession();
+        s->qobject()->setParent(this);
+        if (options.audio)
+            s->setAudioInputDevice(TEST_AUDIO_IN);
+        if (options.video)
+            s->setVideoInputDevice(TEST_VIDEO_IN);
+        s->setLocalAudioPreferences(audioParams);
+        s->setLocalVideoPreferences(videoParams);
+        connect(s->qobject(), SIGNAL(started()), SLOT(sender_started()));
+        connect(s->qobject(), SIGNAL(stopped()), SLOT(session_stopped()));
+        connect(s->qobject(), SIGNAL(error()), SLOT(session_error()));
+        senders += s;
+    }
+
+    receiver = provider->createRtpSession();
+    receiver->qobject()->setParent(this);
+    if (options.audio)
+        receiver->setAudioOutputDevice(TEST_AUDIO_OUT);
+    receiver->setLocalAudioPreferences(audioParams);
+    receiver->setLocalVideoPreferences(videoParams);
+    receiver->setAudioConference(options.conference);
+    connect(receiver->qobject(), SIGNAL(started()), SLOT(receiver_started()));
+    connect(receiver->qobject(), SIGNAL(stopped()), SLOT(session_stopped()));
+    connect(receiver->qobject(), SIGNAL(error()), SLOT(session_error()));
+}
+
+TestCall::~TestCall()
+{
+    // the sessions are children, but their channels must not call back
+    //   into a half destroyed call
+    for (RtpSessionContext *s : std::as_const(senders)) {
+        s->audioRtpChannel()->qobject()->disconnect(this);
+        s->videoRtpChannel()->qobject()->disconnect(this);
+    }
+}
+
+void TestCall::start()
+{
+    state   = Starting;
+    started = 0;
+    for (RtpSessionContext *s : std::as_const(senders))
+        s->start();
+}
+
+void TestCall::stop()
+{
+    state   = Stopping;
+    stopped = 0;
+    for (RtpSessionContext *s : std::as_const(senders))
+        s->stop();
+    receiver->stop();
+}
+
+void TestCall::sender_started()
+{
+    QObject *s = sender();
+    for (RtpSessionContext *c : std::as_const(senders)) {
+        if (c->qobject() != s)
+            continue;
+        c->audioRtpChannel()->setEnabled(true);
+        c->videoRtpChannel()->setEnabled(true);
+        connect(c->audioRtpChannel()->qobject(), SIGNAL(readyRead()), SLOT(audio_readyRead()));
+        connect(c->videoRtpChannel()->qobject(), SIGNAL(readyRead()), SLOT(video_readyRead()));
+    }
+
+    if (++started < senders.count())
+        return;
+
+    // every sender offers the same, so the first one speaks for all
+    if (options.audio)
+        receiver->setRemoteAudioPreferences(senders.first()->localAudioPayloadInfo());
+    if (options.video)
+        receiver->setRemoteVideoPreferences(senders.first()->localVideoPayloadInfo());
+    receiver->start();
+}
+
+void TestCall::receiver_started()
+{
+    receiver->audioRtpChannel()->setEnabled(true);
+    receiver->videoRtpChannel()->setEnabled(true);
+
+    for (RtpSessionContext *s : std::as_const(senders)) {
+        if (!options.transmit)
+            break;
+        if (options.audio)
+            s->transmitAudio();
+        if (options.video)
+            s->transmitVideo();
+    }
+    state = Transmitting;
+}
+
+void TestCall::session_stopped()
+{
+    if (state == Stopping && ++stopped == senders.count() + 1)
+        state = Stopped;
+}
+
+void TestCall::session_error() { error = true; }
+
+void TestCall::audio_readyRead() { relay(false); }
+
+void TestCall::video_readyRead() { relay(true); }
+
+void TestCall::relay(bool video)
+{
+    for (RtpSessionContext *s : std::as_const(senders)) {
+        RtpChannelContext *from    = video ? s->videoRtpChannel() : s->audioRtpChannel();
+        const auto         packets = from->readAll();
+        if (packets.isEmpty() || state != Transmitting)
+            continue;
+
+        RtpChannelContext *to = video ? receiver->videoRtpChannel() : receiver->audioRtpChannel();
+        to->writeBatch(packets);
+        (video ? videoRelayed : audioRelayed) += quint64(packets.count());
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+#ifndef PSIMEDIA_HARNESS_H
+#define PSIMEDIA_HARNESS_H
+
+#include "psimediaprovider.h"
+
+#include <QList>
+#include <QObject>
+#include <functional>
+
+// device ids are gstreamer launch lines, so test sources stand in for
+//   capture and playback and nothing has to be plugged in. video inputs
+//   are looked up among the devices, so the test one is marked as a
+//   launch line (see PIPELINE_LAUNCH_PREFIX)
+#define TEST_AUDIO_IN "audiotestsrc is-live=true wave=ticks"
+#define TEST_AUDIO_OUT "fakesink sync=true"
+#define TEST_VIDEO_IN "launch:videotestsrc is-live=true pattern=ball"
+
+namespace PsiMedia {
+
+class GstProvider;
+
+namespace Test {
+
+    // the provider, or nullptr if gstreamer couldn't be set up. needs a
+    //   QCoreApplication
+    GstProvider *createProvider();
+
+    // cpu time used by the whole process so far, in ms
+    qint64 cpuTime();
+
+    // runs the event loop until cond() holds or ms have passed
+    bool waitFor(const std::function<bool()> &cond, int ms);
+
+    // runs the event loop for ms
+    void run(int ms);
+
+}
+
+// one receiving session fed by any number of sending sessions, with the
+//   rtp of the senders handed to the receiver through their channels the
+//   way an application would. everything is on test sources and sinks
+class TestCall : public QObject {
+    Q_OBJECT
+
+public:
+    class Options {
+    public:
+        bool audio      = true;
+        bool video      = false;
+        int  senders    = 1;
+        bool conference = false; // the receiver mixes the senders' audio
+        bool transmit   = true;  // or else the caller tells the senders to
+    };
+
+    TestCall(Provider *provider, const Options &options, QObject *parent = nullptr);
+    ~TestCall() override;
+
+    // starts the senders, then the receiver with their payload info.
+    //   the senders transmit once the receiver is up, unless the options
+    //   leave that to the caller
+    void start();
+    void stop();
+
+    bool isStarted() const { return state == Transmitting; }
+    bool isStopped() const { return state == Stopped; }
+    bool hasError() const { return error; }
+
+    QList<RtpSessionContext *> senders;
+    RtpSessionContext         *receiver = nullptr;
+
+    quint64 audioRelayed = 0; // rtp and rtcp packets handed over
+    quint64 videoRelayed = 0;
+
+private slots:
+    void sender_started();
+    void receiver_started();
+    void session_stopped();
+    void session_error();
+    void audio_readyRead();
+    void video_readyRead();
+
+private:
+    enum State { Idle, Starting, Transmitting, Stopping, Stopped };
+
+    Options options;
+    State   state   = Idle;
+    bool    error   = false;
+    int     started = 0;
+    int     stopped = 0;
+
+    void relay(bool video);
+};
+
+}
+
+#endif // PSIMEDIA_HARNESS_H
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// the opus options have to end up on the encoder and decoder of the bins
+//   a session gets from the pool: bitrate, frame size (rounded down to one
+//   opus has), fec with a loss figure that makes it send something, dtx,
+//   and concealment on the decoder
+
+#include "binpool.h"
+#include "psimediaprovider.h"
+
+#include <QCoreApplication>
+#include <cstdio>
+#include <gst/gst.h>
+
+using namespace PsiMedia;
+
+#define PT_OPUS 111
+
+static int intProp(GstElement *e, const char *name)
+{
+    int val = -1;
+    g_object_get(G_OBJECT(e), name, &val, nullptr);
+    return val;
+}
+
+static bool boolProp(GstElement *e, const char *name)
+{
+    gboolean val = FALSE;
+    g_object_get(G_OBJECT(e), name, &val, nullptr);
+    return val;
+}
+
+static QByteArray enumProp(GstElement *e, const char *name)
+{
+    GParamSpec *spec = g_object_class_find_property(G_OBJECT_GET_CLASS(e), name);
+    if (!spec || !G_IS_PARAM_SPEC_ENUM(spec))
+        return QByteArray();
+
+    GValue val = G_VALUE_INIT;
+    g_value_init(&val, G_PARAM_SPEC_VALUE_TYPE(spec));
+    g_object_get_property(G_OBJECT(e), name, &val);
+    GEnumClass *klass = G_ENUM_CLASS(g_type_class_ref(G_VALUE_TYPE(&val)));
+    GEnumValue *ev    = g_enum_get_value(klass, g_value_get_enum(&val));
+    QByteArray  nick  = ev ? QByteArray(ev->value_nick) : QByteArray();
+    g_type_class_unref(klass);
+    g_value_unset(&val);
+    return nick;
+}
+
+// the named element of a bin from the pool
+static GstElement *element(GstElement *bin, const char *name)
+{
+    return bin ? gst_bin_get_by_name(GST_BIN(bin), name) : nullptr;
+}
+
+static void drop(GstElement *bin, GstElement *e)
+{
+    if (e)
+        gst_object_unref(e);
+    if (bin) {
+        gst_element_set_state(bin, GST_STATE_NULL);
+        gst_object_ref_sink(bin);
+        gst_object_unref(bin);
+    }
+}
+
+static bool check(const char *name, bool ok)
+{
+    printf("%-32s %s\n", name, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool checkEncoder(const char *name, const POpusOptions &opus, int bitrate, const char *frameSize, bool fec,
+                         int loss, bool dtx)
+{
+    GstElement *bin = BinPool::instance()->audioenc("opus", PT_OPUS, 16000, 16, 2, opus);
+    GstElement *enc = element(bin, "audioenc");
+    bool        ok  = enc != nullptr;
+    if (ok) {
+        ok = (bitrate < 0 || intProp(enc, "bitrate") == bitrate) && enumProp(enc, "frame-size") == frameSize
+            && boolProp(enc, "inband-fec") == fec && intProp(enc, "packet-loss-percentage") == loss
+            && boolProp(enc, "dtx") == dtx;
+    }
+    drop(bin, enc);
+    return check(name, ok);
+}
+
+static bool checkDecoder(const char *name, const POpusOptions &opus)
+{
+    GstElement *bin = BinPool::instance()->audiodec("opus", opus);
+    GstElement *dec = element(bin, "audiodec");
+    bool        ok  = dec && boolProp(dec, "plc") && boolProp(dec, "use-inband-fec") == opus.inbandFec;
+    drop(bin, dec);
+    return check(name, ok);
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    gst_init(nullptr, nullptr);
+
+    GstElementFactory *factory = gst_element_factory_find("opusenc");
+    if (!factory) {
+        printf("opus isn't installed, skipped\n");
+        return 77;
+    }
+    gst_object_unref(factory);
+
+    bool ok = true;
+
+    POpusOptions plain;
+    ok &= checkEncoder("encoder defaults", plain, -1, "20", false, 0, false);
+    ok &= checkDecoder("decoder defaults", plain);
+
+    POpusOptions fec;
+    fec.inbandFec = true;
+    ok &= checkEncoder("fec assumes some loss", fec, -1, "20", true, OPUS_FEC_LOSS, false);
+    ok &= checkDecoder("decoder with fec", fec);
+
+    POpusOptions all;
+    all.bitrate      = 32;
+    all.frameSize    = 10;
+    all.inbandFec    = true;
+    all.expectedLoss = 25;
+    all.dtx          = true;
+    ok &= checkEncoder("bitrate, frame size, loss, dtx", all, 32000, "10", true, 25, true);
+
+    POpusOptions odd;
+    odd.frameSize = 30;
+    ok &= checkEncoder("frame size rounds down", odd, -1, "20", false, 0, false);
+    odd.frameSize = 3;
+    ok &= checkEncoder("frame size under 5", odd, -1, "2.5", false, 0, false);
+
+    return ok ? 0 : 1;
+}
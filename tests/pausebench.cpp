@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// not transmitting, whether not yet or paused, has to stop the encoders,
+//   not just drop what they make. reports the cpu time of a call before
+//   it transmits, while sending audio and video and while paused, which
+//   depends on the machine and on how busy it is, then checks that media
+//   starts and comes back
+
+#include "gstprovider.h"
+#include "harness.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <cstdio>
+
+using namespace PsiMedia;
+
+// cpu ms per second over the next seconds
+static double cpuPerSecond(int seconds)
+{
+    qint64 cpu = Test::cpuTime();
+    Test::run(seconds * 1000);
+    return double(Test::cpuTime() - cpu) / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "seconds", "How long each state is measured.", "seconds", "3" });
+    parser.process(app);
+
+    int  seconds  = qMax(parser.value("seconds").toInt(), 1);
+    auto provider = Test::createProvider();
+    if (!provider)
+        return 1;
+
+    TestCall::Options options;
+    options.video    = true;
+    options.transmit = false;
+
+    auto call = new TestCall(provider, options);
+    call->start();
+    bool ok = Test::waitFor([&]() { return call->isStarted() || call->hasError(); }, 30000) && call->isStarted();
+    if (ok) {
+        RtpSessionContext *sender = call->senders.first();
+
+        Test::run(500);
+        quint64 before      = call->videoRelayed;
+        double  idle        = cpuPerSecond(seconds);
+        quint64 beforeStart = call->videoRelayed - before;
+
+        sender->transmitAudio();
+        sender->transmitVideo();
+        Test::run(1000);
+        before          = call->videoRelayed;
+        double  sending = cpuPerSecond(seconds);
+        quint64 started = call->videoRelayed - before;
+
+        sender->pauseAudio();
+        sender->pauseVideo();
+        Test::run(500);
+        before              = call->videoRelayed;
+        double  paused      = cpuPerSecond(seconds);
+        quint64 whilePaused = call->videoRelayed - before;
+
+        sender->transmitAudio();
+        sender->transmitVideo();
+        before = call->videoRelayed;
+        Test::run(seconds * 1000);
+        quint64 resumed = call->videoRelayed - before;
+
+        printf("not yet sending %.1f cpu ms/s, %.0f%% saved\n", idle,
+               sending > 0 ? (sending - idle) * 100 / sending : 0.0);
+        printf("sending %.1f cpu ms/s, paused %.1f cpu ms/s, %.0f%% saved\n", sending, paused,
+               sending > 0 ? (sending - paused) * 100 / sending : 0.0);
+        printf("video packets: %llu before sending, %llu sending, %llu while paused, %llu after resuming\n",
+               (unsigned long long)beforeStart, (unsigned long long)started, (unsigned long long)whilePaused,
+               (unsigned long long)resumed);
+
+        // rtcp goes out while not transmitting, so only a clear rise counts
+        if (started <= beforeStart * 2) {
+            printf("video didn't start after transmitting  FAIL\n");
+            ok = false;
+        }
+        if (resumed <= whilePaused * 2) {
+            printf("video didn't come back after resuming  FAIL\n");
+            ok = false;
+        }
+    }
+    if (call->hasError())
+        ok = false;
+
+    call->stop();
+    Test::waitFor([&]() { return call->isStopped(); }, 10000);
+    delete call;
+    delete provider;
+    return ok ? 0 : 1;
+}
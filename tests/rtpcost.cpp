@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// time per packet for turning packets into gst buffers on the receive
+//   path and gst buffers into packets on the send path, the way it was
+//   done before the packets were wrapped and pooled and the way it is
+//   done now. the numbers are only reported, since they depend on the
+//   machine and on how busy it is
+
+#include "rtppacketpool.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <gst/gst.h>
+#include <vector>
+
+using namespace PsiMedia;
+
+#define PACKET_SIZE 1200
+#define BATCH 100
+#define ROUNDS 1000
+#define RUNS 5
+
+// ns per packet of the fastest of RUNS runs, after one to warm up. each
+//   run handles ROUNDS batches of BATCH packets
+static double measure(const std::function<void()> &batch)
+{
+    batch();
+
+    qint64 best = -1;
+    for (int run = 0; run < RUNS; ++run) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int n = 0; n < ROUNDS; ++n)
+            batch();
+        qint64 ns = timer.nsecsElapsed();
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    return double(best) / (ROUNDS * BATCH);
+}
+
+static void report(const char *name, double before, double after)
+{
+    printf("%-8s before %8.1f ns/packet, after %8.1f ns/packet (%.2fx)\n", name, before, after,
+           after > 0 ? before / after : 0.0);
+}
+
+// how makeGstBuffer() used to do it: a fresh memory and a copy
+static GstBuffer *copyToBuffer(const PRtpPacket &packet)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GstMemory *memory = gst_allocator_alloc(nullptr, gsize(packet.rawValue.size()), nullptr);
+    GstMapInfo info;
+    gst_memory_map(memory, &info, GST_MAP_WRITE);
+    memcpy(info.data, packet.rawValue.constData(), size_t(packet.rawValue.size()));
+    gst_memory_unmap(memory, &info);
+    gst_buffer_insert_memory(buffer, -1, memory);
+    return buffer;
+}
+
+// how the appsinks used to do it: a fresh array and a copy
+static PRtpPacket copyFromBuffer(GstBuffer *buffer)
+{
+    int        sz = int(gst_buffer_get_size(buffer));
+    QByteArray ba;
+    ba.resize(sz);
+    gst_buffer_extract(buffer, 0, ba.data(), gsize(sz));
+
+    PRtpPacket packet;
+    packet.rawValue = ba;
+    return packet;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    gst_init(nullptr, nullptr);
+
+    RtpPacketPool *pool = RtpPacketPool::instance();
+    char           payload[PACKET_SIZE];
+    memset(payload, 0x80, sizeof(payload));
+
+    // packets written by the application own their bytes, and the buffers
+    //   are held a batch at a time, as if by a jitter buffer
+    PRtpPacket packet;
+    packet.rawValue = QByteArray(payload, PACKET_SIZE);
+    std::vector<GstBuffer *> buffers;
+    buffers.reserve(BATCH);
+    auto release = [&]() {
+        for (GstBuffer *b : buffers)
+            gst_buffer_unref(b);
+        buffers.clear();
+    };
+
+    double copyIn = measure([&]() {
+        for (int i = 0; i < BATCH; ++i)
+            buffers.push_back(copyToBuffer(packet));
+        release();
+    });
+    double wrapIn = measure([&]() {
+        for (int i = 0; i < BATCH; ++i)
+            buffers.push_back(pool->wrap(packet));
+        release();
+    });
+    report("receive", copyIn, wrapIn);
+
+    GstBuffer *buffer = gst_buffer_new_allocate(nullptr, PACKET_SIZE, nullptr);
+    gst_buffer_fill(buffer, 0, payload, PACKET_SIZE);
+    std::vector<PRtpPacket> held;
+    held.reserve(BATCH);
+
+    double copyOut = measure([&]() {
+        for (int i = 0; i < BATCH; ++i)
+            held.push_back(copyFromBuffer(buffer));
+        held.clear();
+    });
+    double pooledOut = measure([&]() {
+        for (int i = 0; i < BATCH; ++i)
+            held.push_back(pool->fromBuffer(buffer, false));
+        held.clear();
+    });
+    double viewOut = measure([&]() {
+        for (int i = 0; i < BATCH; ++i)
+            held.push_back(pool->fromBuffer(buffer, true));
+        held.clear();
+    });
+    report("send", copyOut, pooledOut);
+    report("send zc", copyOut, viewOut);
+    gst_buffer_unref(buffer);
+
+    return 0;
+}
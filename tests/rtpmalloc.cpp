@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// heap allocations per packet on the provider's packet paths, once the
+//   pools are warm. every stage of the provider itself has to come in at
+//   zero, batches may allocate per batch but never per packet. wrapping
+//   for gstreamer is listed for reference only, since the buffer and
+//   memory structs belong to gstreamer. so is the egress view with qt5,
+//   where QByteArray::fromRawData() puts the array header on the heap
+
+#include "gstrtpchannel.h"
+#include "rtppacketpool.h"
+
+#include <QCoreApplication>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <gst/gst.h>
+#include <vector>
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+static std::atomic<quint64> mallocs { 0 };
+
+extern "C" {
+void *malloc(size_t size)
+{
+    mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+using namespace PsiMedia;
+
+#define PACKET_SIZE 1200
+#define ROUNDS 100
+
+// allocations made by the second of two runs, the first warms up
+static quint64 count(const std::function<void()> &stage)
+{
+#ifdef __GLIBC__
+    stage();
+    quint64 before = mallocs.load(std::memory_order_relaxed);
+    stage();
+    return mallocs.load(std::memory_order_relaxed) - before;
+#else
+    Q_UNUSED(stage)
+    return 0;
+#endif
+}
+
+static bool report(const char *name, quint64 allocs, int packets, bool mustBeZero)
+{
+    bool ok = !mustBeZero || allocs == 0;
+    printf("%-16s %8.3f mallocs/packet%s\n", name, double(allocs) / packets, ok ? "" : "  FAIL");
+    return ok;
+}
+
+// pushes ROUNDS batches through a channel the way the session does and
+//   reads them back the way an application does
+static quint64 channelBatches(GstRtpChannel &channel, const QVector<PRtpPacket> &batch)
+{
+    return count([&]() {
+        for (int n = 0; n < ROUNDS; ++n) {
+            channel.push_packets_for_read(batch);
+            QCoreApplication::sendPostedEvents(&channel);
+            QVector<PRtpPacket> packets = channel.readAll();
+            Q_UNUSED(packets)
+        }
+    });
+}
+
+int main(int argc, char **argv)
+{
+#ifndef __GLIBC__
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+    printf("counting mallocs needs glibc, skipped\n");
+    return 77;
+#else
+    QCoreApplication app(argc, argv);
+    gst_init(nullptr, nullptr);
+
+    RtpPacketPool *pool = RtpPacketPool::instance();
+    char           payload[PACKET_SIZE];
+    memset(payload, 0x80, sizeof(payload));
+
+    // packets are held a batch at a time, like a jitter buffer would
+    std::vector<PRtpPacket> held;
+    held.reserve(100);
+    const int packets = ROUNDS * 100;
+    bool      ok      = true;
+
+    ok &= report("ingress copy",
+                 count([&]() {
+                     for (int n = 0; n < ROUNDS; ++n) {
+                         for (int i = 0; i < 100; ++i)
+                             held.push_back(pool->copy(payload, PACKET_SIZE));
+                         held.clear();
+                     }
+                 }),
+                 packets, true);
+
+    ok &= report("callback holder",
+                 count([&]() {
+                     PRtpPacket packet = pool->copy(payload, PACKET_SIZE);
+                     for (int n = 0; n < packets; ++n)
+                         pool->release(pool->retain(packet));
+                 }),
+                 packets, true);
+
+    GstBuffer *buffer = gst_buffer_new_allocate(nullptr, PACKET_SIZE, nullptr);
+    gst_buffer_fill(buffer, 0, payload, PACKET_SIZE);
+    for (bool view : { true, false }) {
+        bool mustBeZero = !view || QT_VERSION >= QT_VERSION_CHECK(6, 0, 0);
+        ok &= report(view ? "egress view" : "egress copy",
+                     count([&]() {
+                         for (int n = 0; n < ROUNDS; ++n) {
+                             for (int i = 0; i < 100; ++i)
+                                 held.push_back(pool->fromBuffer(buffer, view));
+                             held.clear();
+                         }
+                     }),
+                     packets, mustBeZero);
+    }
+    gst_buffer_unref(buffer);
+
+    report("gstreamer wrap",
+           count([&]() {
+               PRtpPacket packet = pool->copy(payload, PACKET_SIZE);
+               for (int n = 0; n < packets; ++n)
+                   gst_buffer_unref(pool->wrap(packet));
+           }),
+           packets, false);
+
+    // the cost of a batch mustn't depend on how many packets it holds
+    GstRtpChannel channel;
+    channel.setEnabled(true);
+    channel.setQueueLimits(512, 512, 0);
+    quint64 perBatch[2];
+    int     sizes[2] = { 10, 100 };
+    for (int n = 0; n < 2; ++n) {
+        QVector<PRtpPacket> batch;
+        for (int i = 0; i < sizes[n]; ++i)
+            batch += pool->copy(payload, PACKET_SIZE);
+        perBatch[n] = channelBatches(channel, batch);
+        printf("channel x%-7d %8.3f mallocs/batch\n", sizes[n], double(perBatch[n]) / ROUNDS);
+    }
+    if (perBatch[1] > perBatch[0]) {
+        printf("channel batches allocate per packet  FAIL\n");
+        ok = false;
+    }
+
+    RtpPacketPool::Stats stats = pool->stats();
+    printf("pool: %llu hits, %llu misses\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+    return ok ? 0 : 1;
+#endif
+}
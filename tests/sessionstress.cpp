@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026  Psi IM Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301  USA
+ *
+ */
+
+// many sessions side by side in one process, each with pipelines of its
+//   own. every call has to start, keep its media flowing and stop again
+//   without disturbing the others
+
+#include "gstprovider.h"
+#include "harness.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstdio>
+
+using namespace PsiMedia;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "sessions", "Sessions to run, two per call.", "count", "50" });
+    parser.addOption({ "seconds", "How long the calls run.", "seconds", "10" });
+    parser.addOption({ "video", "Send video as well as audio." });
+    parser.process(app);
+
+    int  callCount = qMax(parser.value("sessions").toInt() / 2, 1);
+    int  seconds   = qMax(parser.value("seconds").toInt(), 2);
+    auto provider  = Test::createProvider();
+    if (!provider)
+        return 1;
+
+    TestCall::Options options;
+    options.video = parser.isSet("video");
+
+    QList<TestCall *> calls;
+    for (int n = 0; n < callCount; ++n)
+        calls += new TestCall(provider, options);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (TestCall *c : std::as_const(calls))
+        c->start();
+
+    auto allStarted = [&]() {
+        return std::all_of(calls.begin(), calls.end(), [](TestCall *c) { return c->isStarted() || c->hasError(); });
+    };
+    bool ok = Test::waitFor(allStarted, 30000);
+    printf("%d sessions started in %lld ms\n", callCount * 2, timer.elapsed());
+
+    // media has to keep flowing in every call, not just get going
+    QList<quint64> relayed;
+    Test::run(seconds * 500);
+    for (TestCall *c : std::as_const(calls))
+        relayed += c->audioRelayed + c->videoRelayed;
+    Test::run(seconds * 500);
+
+    int failed = 0;
+    for (int n = 0; n < calls.count(); ++n) {
+        TestCall *c     = calls[n];
+        quint64   total = c->audioRelayed + c->videoRelayed;
+        if (!c->isStarted() || c->hasError() || relayed[n] == 0 || total <= relayed[n]) {
+            printf("call %d: started=%d error=%d packets=%llu/%llu\n", n, c->isStarted(), c->hasError(),
+                   (unsigned long long)relayed[n], (unsigned long long)total);
+            ++failed;
+        }
+    }
+
+    for (TestCall *c : std::as_const(calls))
+        c->stop();
+    auto allStopped = [&]() {
+        return std::all_of(calls.begin(), calls.end(), [](TestCall *c) { return c->isStopped(); });
+    };
+    if (!Test::waitFor(allStopped, 10000)) {
+        printf("not every session stopped\n");
+        ok = false;
+    }
+
+    qDeleteAll(calls);
+    delete provider;
+
+    printf("%d of %d calls failed\n", failed, callCount);
+    return ok && failed == 0 ? 0 : 1;
+}